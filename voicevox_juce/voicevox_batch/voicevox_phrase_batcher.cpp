@@ -0,0 +1,361 @@
+#include "voicevox_phrase_batcher.h"
+#include "../voicevox_core_host/voicevox_core_host.h"
+
+namespace voicevox
+{
+
+namespace
+{
+    struct PhraseBatchSegment
+    {
+        size_t phraseIndex;
+        size_t frameOffset;
+        size_t numFrames;
+    };
+
+    struct PhraseBatch
+    {
+        std::vector<PhraseBatchSegment> segments;
+        size_t numFrames{ 0 };
+    };
+
+    // Packs phrases in their original order, so that neighbouring phrases of a song share a call.
+    std::vector<PhraseBatch> planPhraseBatches(const std::vector<size_t>& phrase_num_frames, const VoicevoxPhraseBatcherOptions& options)
+    {
+        std::vector<PhraseBatch> batches;
+
+        for (size_t phrase_index = 0; phrase_index < phrase_num_frames.size(); phrase_index++)
+        {
+            const auto num_frames = phrase_num_frames[phrase_index];
+            if (num_frames == 0)
+            {
+                continue;
+            }
+
+            const auto fits_into_last_batch = !batches.empty()
+                && batches.back().numFrames + options.numPaddingFrames + num_frames <= options.maxBatchFrames;
+
+            if (!fits_into_last_batch)
+            {
+                batches.emplace_back();
+            }
+
+            auto& batch = batches.back();
+            const auto frame_offset = batch.segments.empty() ? 0 : batch.numFrames + options.numPaddingFrames;
+
+            batch.segments.push_back({ phrase_index, frame_offset, num_frames });
+            batch.numFrames = frame_offset + num_frames;
+        }
+
+        return batches;
+    }
+
+    template <typename ElementType>
+    void fillPhraseBatchPadding(VoicevoxFrameSpan<ElementType> packed, const PhraseBatch& batch, ElementType padding_value)
+    {
+        size_t previous_end = 0;
+
+        for (const auto& segment : batch.segments)
+        {
+            std::fill(packed.begin() + previous_end, packed.begin() + segment.frameOffset, padding_value);
+            previous_end = segment.frameOffset + segment.numFrames;
+        }
+
+        std::fill(packed.begin() + previous_end, packed.end(), padding_value);
+    }
+
+    // Frame count of every phrase, nullopt when the inputs of a phrase differ in length.
+    std::optional<std::vector<size_t>> collectPhraseNumFrames(const std::vector<VoicevoxBatchPhrase>& phrases, const std::vector<std::vector<float>>* f0_vectors = nullptr)
+    {
+        if (f0_vectors != nullptr && f0_vectors->size() != phrases.size())
+        {
+            return std::nullopt;
+        }
+
+        std::vector<size_t> phrase_num_frames;
+        phrase_num_frames.reserve(phrases.size());
+
+        for (size_t phrase_index = 0; phrase_index < phrases.size(); phrase_index++)
+        {
+            const auto num_frames = phrases[phrase_index].phonemeVector.size();
+
+            if (phrases[phrase_index].noteVector.size() != num_frames
+                || (f0_vectors != nullptr && (*f0_vectors)[phrase_index].size() != num_frames))
+            {
+                return std::nullopt;
+            }
+
+            phrase_num_frames.push_back(num_frames);
+        }
+
+        return phrase_num_frames;
+    }
+
+    std::optional<std::vector<size_t>> collectPhraseNumFrames(const std::vector<VoicevoxSfDecodeSource>& decode_sources)
+    {
+        std::vector<size_t> phrase_num_frames;
+        phrase_num_frames.reserve(decode_sources.size());
+
+        for (const auto& decode_source : decode_sources)
+        {
+            const auto num_frames = decode_source.f0Vector.size();
+
+            if (decode_source.phonemeVector.size() != num_frames || decode_source.volumeVector.size() != num_frames)
+            {
+                return std::nullopt;
+            }
+
+            phrase_num_frames.push_back(num_frames);
+        }
+
+        return phrase_num_frames;
+    }
+
+    // Allocates one input of the batch from the arena, copies the frames of every phrase into it and pads the rest.
+    // get_frames(phrase_index) returns the frames of a phrase, their length must be checked by collectPhraseNumFrames().
+    template <typename ElementType, typename FramesGetter>
+    VoicevoxFrameSpan<ElementType> packPhraseBatch(VoicevoxFrameArena& arena, const PhraseBatch& batch, ElementType padding_value, FramesGetter get_frames)
+    {
+        auto packed = arena.allocate<ElementType>(batch.numFrames);
+        fillPhraseBatchPadding(packed, batch, padding_value);
+
+        for (const auto& segment : batch.segments)
+        {
+            const auto& frames = get_frames(segment.phraseIndex);
+            jassert(frames.size() == segment.numFrames);
+            std::copy(frames.begin(), frames.end(), packed.begin() + segment.frameOffset);
+        }
+
+        return packed;
+    }
+
+    template <typename ElementType>
+    std::vector<ElementType> slicePhraseBatchSegment(VoicevoxFrameSpan<ElementType> packed, const PhraseBatchSegment& segment, size_t elements_per_frame = 1)
+    {
+        const auto* first = packed.data() + segment.frameOffset * elements_per_frame;
+        return std::vector<ElementType>(first, first + segment.numFrames * elements_per_frame);
+    }
+
+    float getMaxAbsoluteDifference(const std::vector<float>& lhs, const std::vector<float>& rhs)
+    {
+        if (lhs.size() != rhs.size())
+        {
+            return std::numeric_limits<float>::infinity();
+        }
+
+        float max_difference = 0.0f;
+        for (size_t index = 0; index < lhs.size(); index++)
+        {
+            max_difference = std::max(max_difference, std::abs(lhs[index] - rhs[index]));
+        }
+
+        return max_difference;
+    }
+}
+
+//==============================================================================
+VoicevoxPhraseBatcher::VoicevoxPhraseBatcher(VoicevoxClient& client, const VoicevoxPhraseBatcherOptions& options_to_use)
+    : voicevoxClient(client)
+    , options(options_to_use)
+{
+}
+
+VoicevoxPhraseBatcher::~VoicevoxPhraseBatcher()
+{
+}
+
+//==============================================================================
+std::optional<std::vector<VoicevoxBatchRender>> VoicevoxPhraseBatcher::render(juce::uint32 speaker_id, const std::vector<VoicevoxBatchPhrase>& phrases)
+{
+    const auto phrase_num_frames = collectPhraseNumFrames(phrases);
+    if (!phrase_num_frames.has_value())
+    {
+        return std::nullopt;
+    }
+
+    std::vector<VoicevoxBatchRender> renders(phrases.size());
+
+    for (const auto& batch : planPhraseBatches(*phrase_num_frames, options))
+    {
+        frameArena.reset();
+
+        const auto phoneme = packPhraseBatch(frameArena, batch, options.paddingPhonemeId, [&](size_t index) -> const auto& { return phrases[index].phonemeVector; });
+        const auto note = packPhraseBatch(frameArena, batch, options.paddingNoteKey, [&](size_t index) -> const auto& { return phrases[index].noteVector; });
+
+        // NOTE: Padding is forced to silence after every stage, so that the next stage sees the same input around each phrase.
+        auto f0 = voicevoxClient.predictSingF0(speaker_id, phoneme, note, frameArena);
+        if (!f0.has_value())
+        {
+            return std::nullopt;
+        }
+        fillPhraseBatchPadding(*f0, batch, 0.0f);
+
+        auto volume = voicevoxClient.predictSingVolume(speaker_id, phoneme, note, *f0, frameArena);
+        if (!volume.has_value())
+        {
+            return std::nullopt;
+        }
+        fillPhraseBatchPadding(*volume, batch, 0.0f);
+
+        const auto audio = voicevoxClient.singBySfDecode(speaker_id, phoneme, *f0, *volume, frameArena);
+        if (!audio.has_value())
+        {
+            return std::nullopt;
+        }
+
+        for (const auto& segment : batch.segments)
+        {
+            auto& render = renders[segment.phraseIndex];
+            render.decodeSource.phonemeVector = phrases[segment.phraseIndex].phonemeVector;
+            render.decodeSource.f0Vector = slicePhraseBatchSegment(*f0, segment);
+            render.decodeSource.volumeVector = slicePhraseBatchSegment(*volume, segment);
+            render.audio = slicePhraseBatchSegment(*audio, segment, VoicevoxCoreHost::samplesPerFrame);
+        }
+    }
+
+    return renders;
+}
+
+std::optional<std::vector<std::vector<float>>> VoicevoxPhraseBatcher::predictF0(juce::uint32 speaker_id, const std::vector<VoicevoxBatchPhrase>& phrases)
+{
+    const auto phrase_num_frames = collectPhraseNumFrames(phrases);
+    if (!phrase_num_frames.has_value())
+    {
+        return std::nullopt;
+    }
+
+    std::vector<std::vector<float>> outputs(phrases.size());
+
+    for (const auto& batch : planPhraseBatches(*phrase_num_frames, options))
+    {
+        frameArena.reset();
+
+        const auto phoneme = packPhraseBatch(frameArena, batch, options.paddingPhonemeId, [&](size_t index) -> const auto& { return phrases[index].phonemeVector; });
+        const auto note = packPhraseBatch(frameArena, batch, options.paddingNoteKey, [&](size_t index) -> const auto& { return phrases[index].noteVector; });
+
+        const auto f0 = voicevoxClient.predictSingF0(speaker_id, phoneme, note, frameArena);
+        if (!f0.has_value())
+        {
+            return std::nullopt;
+        }
+
+        for (const auto& segment : batch.segments)
+        {
+            outputs[segment.phraseIndex] = slicePhraseBatchSegment(*f0, segment);
+        }
+    }
+
+    return outputs;
+}
+
+std::optional<std::vector<std::vector<float>>> VoicevoxPhraseBatcher::predictVolume(juce::uint32 speaker_id, const std::vector<VoicevoxBatchPhrase>& phrases, const std::vector<std::vector<float>>& f0_vectors)
+{
+    const auto phrase_num_frames = collectPhraseNumFrames(phrases, &f0_vectors);
+    if (!phrase_num_frames.has_value())
+    {
+        return std::nullopt;
+    }
+
+    std::vector<std::vector<float>> outputs(phrases.size());
+
+    for (const auto& batch : planPhraseBatches(*phrase_num_frames, options))
+    {
+        frameArena.reset();
+
+        const auto phoneme = packPhraseBatch(frameArena, batch, options.paddingPhonemeId, [&](size_t index) -> const auto& { return phrases[index].phonemeVector; });
+        const auto note = packPhraseBatch(frameArena, batch, options.paddingNoteKey, [&](size_t index) -> const auto& { return phrases[index].noteVector; });
+        const auto f0 = packPhraseBatch(frameArena, batch, 0.0f, [&](size_t index) -> const auto& { return f0_vectors[index]; });
+
+        const auto volume = voicevoxClient.predictSingVolume(speaker_id, phoneme, note, f0, frameArena);
+        if (!volume.has_value())
+        {
+            return std::nullopt;
+        }
+
+        for (const auto& segment : batch.segments)
+        {
+            outputs[segment.phraseIndex] = slicePhraseBatchSegment(*volume, segment);
+        }
+    }
+
+    return outputs;
+}
+
+std::optional<std::vector<std::vector<float>>> VoicevoxPhraseBatcher::decode(juce::uint32 speaker_id, const std::vector<VoicevoxSfDecodeSource>& decode_sources)
+{
+    const auto phrase_num_frames = collectPhraseNumFrames(decode_sources);
+    if (!phrase_num_frames.has_value())
+    {
+        return std::nullopt;
+    }
+
+    std::vector<std::vector<float>> outputs(decode_sources.size());
+
+    for (const auto& batch : planPhraseBatches(*phrase_num_frames, options))
+    {
+        frameArena.reset();
+
+        const auto phoneme = packPhraseBatch(frameArena, batch, options.paddingPhonemeId, [&](size_t index) -> const auto& { return decode_sources[index].phonemeVector; });
+        const auto f0 = packPhraseBatch(frameArena, batch, 0.0f, [&](size_t index) -> const auto& { return decode_sources[index].f0Vector; });
+        const auto volume = packPhraseBatch(frameArena, batch, 0.0f, [&](size_t index) -> const auto& { return decode_sources[index].volumeVector; });
+
+        const auto audio = voicevoxClient.singBySfDecode(speaker_id, phoneme, f0, volume, frameArena);
+        if (!audio.has_value())
+        {
+            return std::nullopt;
+        }
+
+        for (const auto& segment : batch.segments)
+        {
+            outputs[segment.phraseIndex] = slicePhraseBatchSegment(*audio, segment, VoicevoxCoreHost::samplesPerFrame);
+        }
+    }
+
+    return outputs;
+}
+
+//==============================================================================
+std::optional<VoicevoxBatchVerification> VoicevoxPhraseBatcher::verifyAgainstIndividualRender(juce::uint32 speaker_id, const std::vector<VoicevoxBatchPhrase>& phrases)
+{
+    VoicevoxBatchVerification verification;
+
+    const auto batched_start_ticks = juce::Time::getHighResolutionTicks();
+    const auto batched_renders = render(speaker_id, phrases);
+    verification.batchedSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - batched_start_ticks);
+
+    if (!batched_renders.has_value())
+    {
+        return std::nullopt;
+    }
+
+    std::vector<VoicevoxBatchRender> individual_renders;
+    individual_renders.reserve(phrases.size());
+
+    // NOTE: A batch of one phrase has no padding, so it is exactly the individual render.
+    const auto individual_start_ticks = juce::Time::getHighResolutionTicks();
+    for (const auto& phrase : phrases)
+    {
+        auto individual_render = render(speaker_id, { phrase });
+        if (!individual_render.has_value())
+        {
+            return std::nullopt;
+        }
+
+        individual_renders.push_back(std::move(individual_render->front()));
+    }
+    verification.individualSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - individual_start_ticks);
+
+    for (size_t index = 0; index < phrases.size(); index++)
+    {
+        const auto& batched = (*batched_renders)[index];
+        const auto& individual = individual_renders[index];
+
+        verification.maxF0Difference = std::max(verification.maxF0Difference, getMaxAbsoluteDifference(batched.decodeSource.f0Vector, individual.decodeSource.f0Vector));
+        verification.maxVolumeDifference = std::max(verification.maxVolumeDifference, getMaxAbsoluteDifference(batched.decodeSource.volumeVector, individual.decodeSource.volumeVector));
+        verification.maxAudioDifference = std::max(verification.maxAudioDifference, getMaxAbsoluteDifference(batched.audio, individual.audio));
+    }
+
+    return verification;
+}
+
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "../voicevox_client/voicevox_client.h"
+
+namespace voicevox
+{
+
+//==============================================================================
+/** Frame aligned inputs of one short phrase. */
+struct VoicevoxBatchPhrase
+{
+    std::vector<std::int64_t> phonemeVector{};
+    std::vector<std::int64_t> noteVector{};
+};
+
+struct VoicevoxBatchRender
+{
+    VoicevoxSfDecodeSource decodeSource{};
+    std::vector<float> audio{};
+};
+
+struct VoicevoxBatchVerification
+{
+    float maxF0Difference{ 0.0f };
+    float maxVolumeDifference{ 0.0f };
+    float maxAudioDifference{ 0.0f };
+
+    double batchedSeconds{ 0.0 };
+    double individualSeconds{ 0.0 };
+};
+
+struct VoicevoxPhraseBatcherOptions
+{
+    // Silent frames between two packed phrases, keep it longer than the context the models look at.
+    size_t numPaddingFrames{ 48 };
+
+    // Frame values of the padding, "pau" phoneme and rest note.
+    std::int64_t paddingPhonemeId{ 0 };
+    std::int64_t paddingNoteKey{ -1 };
+
+    // Phrases are packed up to this many frames per call, a longer phrase is rendered alone.
+    size_t maxBatchFrames{ 4096 };
+};
+
+//==============================================================================
+/**
+    Renders many short phrases of one speaker with as few core calls as possible.
+
+    Phrases are packed into one frame sequence separated by silent padding,
+    every song stage runs once on the packed sequence, and the outputs are
+    split back per phrase. For phrases of a few dozen frames the fixed cost
+    of each call dominates, so this saves most of the render time.
+
+    NOTE: Whether the padding fully isolates the phrases depends on the
+          models, check with verifyAgainstIndividualRender() before relying
+          on it for a new model.
+
+    This class is not thread safe, every call resets the scratch arena of
+    the batcher. Use one batcher per thread, they can share the client.
+*/
+class VoicevoxPhraseBatcher final
+{
+public:
+    //==============================================================================
+    explicit VoicevoxPhraseBatcher(VoicevoxClient& client, const VoicevoxPhraseBatcherOptions& options = {});
+    ~VoicevoxPhraseBatcher();
+
+    //==============================================================================
+    // Every call returns nullopt without calling the core when the inputs of a phrase differ in length.
+
+    // Runs f0, volume and decode stages, results are in the order of the phrases.
+    std::optional<std::vector<VoicevoxBatchRender>> render(juce::uint32 speaker_id, const std::vector<VoicevoxBatchPhrase>& phrases);
+
+    // Runs f0 stage only, results are in the order of the phrases.
+    std::optional<std::vector<std::vector<float>>> predictF0(juce::uint32 speaker_id, const std::vector<VoicevoxBatchPhrase>& phrases);
+
+    // Runs volume stage only, f0Vectors and results are in the order of the phrases.
+    std::optional<std::vector<std::vector<float>>> predictVolume(juce::uint32 speaker_id, const std::vector<VoicevoxBatchPhrase>& phrases, const std::vector<std::vector<float>>& f0_vectors);
+
+    // Runs decode stage only, results are in the order of the sources.
+    std::optional<std::vector<std::vector<float>>> decode(juce::uint32 speaker_id, const std::vector<VoicevoxSfDecodeSource>& decode_sources);
+
+    //==============================================================================
+    // Renders the phrases batched and one by one, and compares both outputs and render times.
+    std::optional<VoicevoxBatchVerification> verifyAgainstIndividualRender(juce::uint32 speaker_id, const std::vector<VoicevoxBatchPhrase>& phrases);
+
+private:
+    //==============================================================================
+    VoicevoxClient& voicevoxClient;
+    const VoicevoxPhraseBatcherOptions options;
+
+    // Reset at the start of every call.
+    VoicevoxFrameArena frameArena;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VoicevoxPhraseBatcher)
+};
+
+}
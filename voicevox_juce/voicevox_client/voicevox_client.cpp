@@ -1,9 +1,43 @@
 #include "voicevox_client.h"
 #include "../voicevox_core_host/voicevox_core_host.h"
+#include "../voicevox_dsp/voicevox_audio_kernels.h"
+#include "../voicevox_log/voicevox_event_log.h"
+#include "../voicevox_trace/voicevox_trace_recorder.h"
 
 namespace voicevox
 {
 
+namespace
+{
+    // Runs the call and writes it to the recorder, inputs are serialized only while recording.
+    template <typename InputWriter, typename CoreCall>
+    auto callWithTraceRecorder(const std::shared_ptr<VoicevoxTraceRecorder>& recorder, VoicevoxServerMethod method, juce::uint32 speaker_id, InputWriter&& write_inputs, CoreCall&& call)
+    {
+        if (recorder == nullptr)
+        {
+            return call();
+        }
+
+        const auto start_ticks = juce::Time::getHighResolutionTicks();
+        auto result = call();
+        const auto end_ticks = juce::Time::getHighResolutionTicks();
+
+        juce::MemoryOutputStream inputs;
+        write_inputs(inputs);
+
+        if (result.has_value())
+        {
+            recorder->record(method, speaker_id, start_ticks, end_ticks, inputs.getMemoryBlock(), true, result->data(), result->size() * sizeof(*result->data()));
+        }
+        else
+        {
+            recorder->record(method, speaker_id, start_ticks, end_ticks, inputs.getMemoryBlock(), false, nullptr, 0);
+        }
+
+        return result;
+    }
+}
+
 //==============================================================================
 VoicevoxClient::VoicevoxClient()
     : isConnected_(false)
@@ -21,19 +55,20 @@ void VoicevoxClient::connect()
     sharedVoicevoxCoreHost = std::make_unique<voicevox::SharedVoicevoxCoreHost>();
     isConnected_ = true;
 
-    juce::Logger::outputDebugString("[voicevox_juce] voicevox_core version: " + sharedVoicevoxCoreHost->getObject().getVersion());
-
-    const auto devices = juce::JSON::toString(sharedVoicevoxCoreHost->getObject().getSupportedDevicesJson());
-    juce::Logger::outputDebugString("[voicevox_juce] voicevox_core supported devices: " + devices);
-
-    const juce::String str_is_gpu_mode = sharedVoicevoxCoreHost->getObject().isGPUMode() ? "true" : "false";
-    juce::Logger::outputDebugString("[voicevox_juce] voicevox_core is gpu mode: " + str_is_gpu_mode);
+    // NOTE: Log records carry no text, version and supported devices are read with getCoreVersion() and getSupportedDevicesJson().
+    if (VoicevoxEventLog::getInstance().shouldLog(VoicevoxLogLevel::Info))
+    {
+        const auto is_gpu_mode = sharedVoicevoxCoreHost->getObject().isGPUMode();
+        VoicevoxEventLog::log(VoicevoxLogLevel::Info, VoicevoxEventId::Connect, 0, 0, 0, is_gpu_mode ? 1 : 0);
+    }
 }
 
 void VoicevoxClient::disconnect()
 {
     sharedVoicevoxCoreHost.reset();
     isConnected_ = false;
+
+    VoicevoxEventLog::log(VoicevoxLogLevel::Info, VoicevoxEventId::Disconnect);
 }
 
 bool VoicevoxClient::isConnected() const
@@ -41,6 +76,27 @@ bool VoicevoxClient::isConnected() const
     return isConnected_.load();
 }
 
+//==============================================================================
+juce::String VoicevoxClient::getCoreVersion() const
+{
+    if (isConnected())
+    {
+        return sharedVoicevoxCoreHost->getObject().getVersion();
+    }
+
+    return juce::String();
+}
+
+juce::var VoicevoxClient::getSupportedDevicesJson() const
+{
+    if (isConnected())
+    {
+        return sharedVoicevoxCoreHost->getObject().getSupportedDevicesJson();
+    }
+
+    return juce::var();
+}
+
 //==============================================================================
 juce::var VoicevoxClient::getMetasJson() const
 {
@@ -56,7 +112,17 @@ juce::Result VoicevoxClient::loadModel(juce::uint32 speaker_id)
 {
     if (isConnected())
     {
-        return sharedVoicevoxCoreHost->getObject().loadModel(speaker_id);
+        const auto recorder = getTraceRecorder();
+        if (recorder == nullptr)
+        {
+            return sharedVoicevoxCoreHost->getObject().loadModel(speaker_id);
+        }
+
+        const auto start_ticks = juce::Time::getHighResolutionTicks();
+        const auto result = sharedVoicevoxCoreHost->getObject().loadModel(speaker_id);
+        recorder->record(VoicevoxServerMethod::LoadModel, speaker_id, start_ticks, juce::Time::getHighResolutionTicks(), {}, result.wasOk(), nullptr, 0);
+
+        return result;
     }
 
     return juce::Result::fail("Disconnected");
@@ -93,7 +159,12 @@ std::optional<std::vector<std::byte>> VoicevoxClient::synthesis(juce::uint32 spe
 {
     if (isConnected())
     {
-        return sharedVoicevoxCoreHost->getObject().synthesis(speaker_id, audio_query_json);
+        return callWithTraceRecorder(getTraceRecorder(), VoicevoxServerMethod::Synthesis, speaker_id,
+                                     [&](juce::MemoryOutputStream& inputs)
+                                     {
+                                         inputs.writeString(audio_query_json);
+                                     },
+                                     [&] { return sharedVoicevoxCoreHost->getObject().synthesis(speaker_id, audio_query_json); });
     }
 
     return std::nullopt;
@@ -103,7 +174,12 @@ std::optional<std::vector<std::byte>> VoicevoxClient::tts(juce::uint32 speaker_i
 {
     if (isConnected())
     {
-        return sharedVoicevoxCoreHost->getObject().tts(speaker_id, speak_words);
+        return callWithTraceRecorder(getTraceRecorder(), VoicevoxServerMethod::Tts, speaker_id,
+                                     [&](juce::MemoryOutputStream& inputs)
+                                     {
+                                         inputs.writeString(speak_words);
+                                     },
+                                     [&] { return sharedVoicevoxCoreHost->getObject().tts(speaker_id, speak_words); });
     }
 
     return std::nullopt;
@@ -113,7 +189,14 @@ std::optional<std::vector<std::int64_t>> VoicevoxClient::predictSingConsonantLen
 {
     if (isConnected())
     {
-        return sharedVoicevoxCoreHost->getObject().predict_sing_consonant_length_forward(speaker_id, note_consonant_vector, note_vowel_vector, note_length_vector);
+        return callWithTraceRecorder(getTraceRecorder(), VoicevoxServerMethod::PredictSingConsonantLength, speaker_id,
+                                     [&](juce::MemoryOutputStream& inputs)
+                                     {
+                                         VoicevoxServerProtocol::writeVector(inputs, note_consonant_vector);
+                                         VoicevoxServerProtocol::writeVector(inputs, note_vowel_vector);
+                                         VoicevoxServerProtocol::writeVector(inputs, note_length_vector);
+                                     },
+                                     [&] { return sharedVoicevoxCoreHost->getObject().predict_sing_consonant_length_forward(speaker_id, note_consonant_vector, note_vowel_vector, note_length_vector); });
     }
 
     return std::nullopt;
@@ -123,7 +206,13 @@ std::optional<std::vector<float>> VoicevoxClient::predictSingF0(juce::uint32 spe
 {
     if (isConnected())
     {
-        return sharedVoicevoxCoreHost->getObject().predict_sing_f0_forward(speaker_id, phoneme_flatten, note_vector);
+        return callWithTraceRecorder(getTraceRecorder(), VoicevoxServerMethod::PredictSingF0, speaker_id,
+                                     [&](juce::MemoryOutputStream& inputs)
+                                     {
+                                         VoicevoxServerProtocol::writeVector(inputs, phoneme_flatten);
+                                         VoicevoxServerProtocol::writeVector(inputs, note_vector);
+                                     },
+                                     [&] { return sharedVoicevoxCoreHost->getObject().predict_sing_f0_forward(speaker_id, phoneme_flatten, note_vector); });
     }
 
     return std::nullopt;
@@ -133,7 +222,14 @@ std::optional<std::vector<float>> VoicevoxClient::predictSingVolume(juce::uint32
 {
     if (isConnected())
     {
-        return sharedVoicevoxCoreHost->getObject().predict_sing_volume_forward(speaker_id, phoneme, note, f0);
+        return callWithTraceRecorder(getTraceRecorder(), VoicevoxServerMethod::PredictSingVolume, speaker_id,
+                                     [&](juce::MemoryOutputStream& inputs)
+                                     {
+                                         VoicevoxServerProtocol::writeVector(inputs, phoneme);
+                                         VoicevoxServerProtocol::writeVector(inputs, note);
+                                         VoicevoxServerProtocol::writeVector(inputs, f0);
+                                     },
+                                     [&] { return sharedVoicevoxCoreHost->getObject().predict_sing_volume_forward(speaker_id, phoneme, note, f0); });
     }
 
     return std::nullopt;
@@ -143,10 +239,194 @@ std::optional<std::vector<float>> VoicevoxClient::singBySfDecode(juce::uint32 sp
 {
     if (isConnected())
     {
-        return sharedVoicevoxCoreHost->getObject().sf_decode_forward(speaker_id, decode_source.phonemeVector, decode_source.f0Vector, decode_source.volumeVector);
+        return callWithTraceRecorder(getTraceRecorder(), VoicevoxServerMethod::SingBySfDecode, speaker_id,
+                                     [&](juce::MemoryOutputStream& inputs)
+                                     {
+                                         VoicevoxServerProtocol::writeVector(inputs, decode_source.phonemeVector);
+                                         VoicevoxServerProtocol::writeVector(inputs, decode_source.f0Vector);
+                                         VoicevoxServerProtocol::writeVector(inputs, decode_source.volumeVector);
+                                     },
+                                     [&] { return sharedVoicevoxCoreHost->getObject().sf_decode_forward(speaker_id, decode_source.phonemeVector, decode_source.f0Vector, decode_source.volumeVector); });
+    }
+
+    return std::nullopt;
+}
+
+//==============================================================================
+std::optional<VoicevoxFrameSpan<std::int64_t>> VoicevoxClient::predictSingConsonantLength(juce::uint32 speaker_id, VoicevoxFrameSpan<const std::int64_t> note_consonant_vector, VoicevoxFrameSpan<const std::int64_t> note_vowel_vector, VoicevoxFrameSpan<const std::int64_t> note_length_vector, VoicevoxFrameArena& arena)
+{
+    if (isConnected())
+    {
+        return callWithTraceRecorder(getTraceRecorder(), VoicevoxServerMethod::PredictSingConsonantLength, speaker_id,
+                                     [&](juce::MemoryOutputStream& inputs)
+                                     {
+                                         VoicevoxServerProtocol::writeArray(inputs, note_consonant_vector.data(), note_consonant_vector.size());
+                                         VoicevoxServerProtocol::writeArray(inputs, note_vowel_vector.data(), note_vowel_vector.size());
+                                         VoicevoxServerProtocol::writeArray(inputs, note_length_vector.data(), note_length_vector.size());
+                                     },
+                                     [&] { return sharedVoicevoxCoreHost->getObject().predict_sing_consonant_length_forward(arena, speaker_id, note_consonant_vector, note_vowel_vector, note_length_vector); });
+    }
+
+    return std::nullopt;
+}
+
+std::optional<VoicevoxFrameSpan<float>> VoicevoxClient::predictSingF0(juce::uint32 speaker_id, VoicevoxFrameSpan<const std::int64_t> phoneme_flatten, VoicevoxFrameSpan<const std::int64_t> note_vector, VoicevoxFrameArena& arena)
+{
+    if (isConnected())
+    {
+        return callWithTraceRecorder(getTraceRecorder(), VoicevoxServerMethod::PredictSingF0, speaker_id,
+                                     [&](juce::MemoryOutputStream& inputs)
+                                     {
+                                         VoicevoxServerProtocol::writeArray(inputs, phoneme_flatten.data(), phoneme_flatten.size());
+                                         VoicevoxServerProtocol::writeArray(inputs, note_vector.data(), note_vector.size());
+                                     },
+                                     [&] { return sharedVoicevoxCoreHost->getObject().predict_sing_f0_forward(arena, speaker_id, phoneme_flatten, note_vector); });
+    }
+
+    return std::nullopt;
+}
+
+std::optional<VoicevoxFrameSpan<float>> VoicevoxClient::predictSingVolume(juce::uint32 speaker_id, VoicevoxFrameSpan<const std::int64_t> phoneme, VoicevoxFrameSpan<const std::int64_t> note, VoicevoxFrameSpan<const float> f0, VoicevoxFrameArena& arena)
+{
+    if (isConnected())
+    {
+        return callWithTraceRecorder(getTraceRecorder(), VoicevoxServerMethod::PredictSingVolume, speaker_id,
+                                     [&](juce::MemoryOutputStream& inputs)
+                                     {
+                                         VoicevoxServerProtocol::writeArray(inputs, phoneme.data(), phoneme.size());
+                                         VoicevoxServerProtocol::writeArray(inputs, note.data(), note.size());
+                                         VoicevoxServerProtocol::writeArray(inputs, f0.data(), f0.size());
+                                     },
+                                     [&] { return sharedVoicevoxCoreHost->getObject().predict_sing_volume_forward(arena, speaker_id, phoneme, note, f0); });
+    }
+
+    return std::nullopt;
+}
+
+std::optional<VoicevoxFrameSpan<float>> VoicevoxClient::singBySfDecode(juce::uint32 speaker_id, VoicevoxFrameSpan<const std::int64_t> phoneme, VoicevoxFrameSpan<const float> f0, VoicevoxFrameSpan<const float> volume, VoicevoxFrameArena& arena)
+{
+    if (isConnected())
+    {
+        return callWithTraceRecorder(getTraceRecorder(), VoicevoxServerMethod::SingBySfDecode, speaker_id,
+                                     [&](juce::MemoryOutputStream& inputs)
+                                     {
+                                         VoicevoxServerProtocol::writeArray(inputs, phoneme.data(), phoneme.size());
+                                         VoicevoxServerProtocol::writeArray(inputs, f0.data(), f0.size());
+                                         VoicevoxServerProtocol::writeArray(inputs, volume.data(), volume.size());
+                                     },
+                                     [&] { return sharedVoicevoxCoreHost->getObject().sf_decode_forward(arena, speaker_id, phoneme, f0, volume); });
     }
 
     return std::nullopt;
 }
 
+//==============================================================================
+juce::Result VoicevoxClient::singBySfDecodeStreaming(juce::uint32 speaker_id, const VoicevoxSfDecodeSource& decode_source, const SampleChunkCallback& on_samples, size_t chunk_frames, size_t context_frames)
+{
+    if (!isConnected())
+    {
+        return juce::Result::fail("Not connected");
+    }
+
+    const auto recorder = getTraceRecorder();
+    if (recorder == nullptr)
+    {
+        return decodeStreaming(speaker_id, decode_source, on_samples, chunk_frames, context_frames);
+    }
+
+    // NOTE: Recorded as SingBySfDecode, the chunk parameters follow the decode inputs as in the VoicevoxServer payload.
+    //       The output checksum covers the samples of every chunk in order.
+    auto output_checksum = VoicevoxTraceRecorder::initialChecksum;
+    juce::uint64 output_num_bytes = 0;
+
+    const auto start_ticks = juce::Time::getHighResolutionTicks();
+    const auto result = decodeStreaming(speaker_id, decode_source,
+                                        [&](const float* samples, size_t num_samples)
+                                        {
+                                            output_checksum = VoicevoxTraceRecorder::checksum(samples, num_samples * sizeof(float), output_checksum);
+                                            output_num_bytes += num_samples * sizeof(float);
+                                            return on_samples(samples, num_samples);
+                                        },
+                                        chunk_frames, context_frames);
+    const auto end_ticks = juce::Time::getHighResolutionTicks();
+
+    juce::MemoryOutputStream inputs;
+    VoicevoxServerProtocol::writeVector(inputs, decode_source.phonemeVector);
+    VoicevoxServerProtocol::writeVector(inputs, decode_source.f0Vector);
+    VoicevoxServerProtocol::writeVector(inputs, decode_source.volumeVector);
+    inputs.writeInt64((juce::int64)chunk_frames);
+    inputs.writeInt64((juce::int64)context_frames);
+
+    recorder->record(VoicevoxServerMethod::SingBySfDecode, speaker_id, start_ticks, end_ticks, inputs.getMemoryBlock(),
+                     result.wasOk(), result.wasOk() ? output_checksum : VoicevoxTraceRecorder::initialChecksum, result.wasOk() ? output_num_bytes : 0);
+
+    return result;
+}
+
+juce::Result VoicevoxClient::decodeStreaming(juce::uint32 speaker_id, const VoicevoxSfDecodeSource& decode_source, const SampleChunkCallback& on_samples, size_t chunk_frames, size_t context_frames)
+{
+    const auto num_frames = decode_source.f0Vector.size();
+    jassert(decode_source.phonemeVector.size() == num_frames && decode_source.volumeVector.size() == num_frames);
+    jassert(chunk_frames > 0);
+
+    auto& voicevox_core_host = sharedVoicevoxCoreHost->getObject();
+
+    // NOTE: One arena per call, it is reset for every chunk and never grows beyond a single window.
+    VoicevoxFrameArena arena;
+
+    // Right context of the previous window, crossfaded into the start of the next chunk.
+    std::vector<float> previous_tail;
+    previous_tail.reserve(context_frames * VoicevoxCoreHost::samplesPerFrame);
+
+    for (size_t chunk_start = 0; chunk_start < num_frames; chunk_start += chunk_frames)
+    {
+        const auto chunk_end = std::min(num_frames, chunk_start + chunk_frames);
+        const auto window_start = chunk_start - std::min(chunk_start, context_frames);
+        const auto window_end = std::min(num_frames, chunk_end + context_frames);
+        const auto window_frames = window_end - window_start;
+
+        arena.reset();
+
+        const auto decoded = voicevox_core_host.sf_decode_forward(arena, speaker_id,
+                                                                  { decode_source.phonemeVector.data() + window_start, window_frames },
+                                                                  { decode_source.f0Vector.data() + window_start, window_frames },
+                                                                  { decode_source.volumeVector.data() + window_start, window_frames });
+        if (!decoded.has_value())
+        {
+            return juce::Result::fail("Failed to decode frames " + juce::String((juce::int64)window_start) + " to " + juce::String((juce::int64)window_end));
+        }
+
+        auto* chunk_samples = decoded->data() + (chunk_start - window_start) * VoicevoxCoreHost::samplesPerFrame;
+        const auto num_chunk_samples = (chunk_end - chunk_start) * VoicevoxCoreHost::samplesPerFrame;
+
+        // NOTE: Both windows decoded the overlapping frames, so fading from one to the other hides the seam.
+        const auto num_crossfade_samples = std::min(previous_tail.size(), num_chunk_samples);
+        VoicevoxAudioKernels::crossfade(previous_tail.data(), chunk_samples, num_crossfade_samples);
+        std::copy(previous_tail.begin(), previous_tail.begin() + (std::ptrdiff_t)num_crossfade_samples, chunk_samples);
+
+        const auto* tail_samples = chunk_samples + num_chunk_samples;
+        previous_tail.assign(tail_samples, tail_samples + (window_end - chunk_end) * VoicevoxCoreHost::samplesPerFrame);
+
+        if (!on_samples(chunk_samples, num_chunk_samples))
+        {
+            return juce::Result::fail("Cancelled");
+        }
+    }
+
+    return juce::Result::ok();
+}
+
+//==============================================================================
+void VoicevoxClient::setTraceRecorder(std::shared_ptr<VoicevoxTraceRecorder> recorder)
+{
+    const juce::SpinLock::ScopedLockType lock(traceRecorderLock);
+    traceRecorder.swap(recorder);
+}
+
+std::shared_ptr<VoicevoxTraceRecorder> VoicevoxClient::getTraceRecorder() const
+{
+    const juce::SpinLock::ScopedLockType lock(traceRecorderLock);
+    return traceRecorder;
+}
+
 }
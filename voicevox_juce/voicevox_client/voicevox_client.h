@@ -1,12 +1,15 @@
 #pragma once
 
 #include <juce_core/juce_core.h>
+#include "../voicevox_log/voicevox_event_log.h"
+#include "../voicevox_memory/voicevox_frame_arena.h"
 
 namespace voicevox
 {
 
 //==============================================================================
 class VoicevoxCoreHost;
+class VoicevoxTraceRecorder;
 using SharedVoicevoxCoreHost = juce::SharedResourcePointer<voicevox::VoicevoxCoreHost>;
 
 struct VoicevoxSfDecodeSource
@@ -31,6 +34,11 @@ public:
     void disconnect();
     bool isConnected() const;
 
+    //==============================================================================
+    // Version string and supported devices JSON of voicevox_core, empty while disconnected.
+    juce::String getCoreVersion() const;
+    juce::var getSupportedDevicesJson() const;
+
     //==============================================================================
     juce::var getMetasJson() const;
     juce::Result loadModel(juce::uint32 speaker_id);
@@ -52,11 +60,41 @@ public:
     std::optional<std::vector<float>> predictSingVolume(juce::uint32 speaker_id, const std::vector<std::int64_t>& phoneme, const std::vector<std::int64_t>& note, const std::vector<float>& f0);
     std::optional<std::vector<float>> singBySfDecode(juce::uint32 speaker_id, const VoicevoxSfDecodeSource& decode_source);
 
+    //==============================================================================
+    // Song API writing into arena, returned spans are valid until the arena is reset.
+    std::optional<VoicevoxFrameSpan<std::int64_t>> predictSingConsonantLength(juce::uint32 speaker_id, VoicevoxFrameSpan<const std::int64_t> note_consonant_vector, VoicevoxFrameSpan<const std::int64_t> note_vowel_vector, VoicevoxFrameSpan<const std::int64_t> note_length_vector, VoicevoxFrameArena& arena);
+    std::optional<VoicevoxFrameSpan<float>> predictSingF0(juce::uint32 speaker_id, VoicevoxFrameSpan<const std::int64_t> phoneme_flatten, VoicevoxFrameSpan<const std::int64_t> note_vector, VoicevoxFrameArena& arena);
+    std::optional<VoicevoxFrameSpan<float>> predictSingVolume(juce::uint32 speaker_id, VoicevoxFrameSpan<const std::int64_t> phoneme, VoicevoxFrameSpan<const std::int64_t> note, VoicevoxFrameSpan<const float> f0, VoicevoxFrameArena& arena);
+    std::optional<VoicevoxFrameSpan<float>> singBySfDecode(juce::uint32 speaker_id, VoicevoxFrameSpan<const std::int64_t> phoneme, VoicevoxFrameSpan<const float> f0, VoicevoxFrameSpan<const float> volume, VoicevoxFrameArena& arena);
+
+    //==============================================================================
+    // Song API decoding chunk by chunk, every chunk of samples is handed to the callback as soon as it is ready.
+    // Return false from the callback to cancel.
+    // NOTE: Each chunk is decoded together with context frames on both sides, and its start is crossfaded with
+    //       the right context of the previous window to hide the seams. The output is close to, but not bit exact
+    //       with, the one shot singBySfDecode.
+    using SampleChunkCallback = std::function<bool(const float* samples, size_t num_samples)>;
+    juce::Result singBySfDecodeStreaming(juce::uint32 speaker_id, const VoicevoxSfDecodeSource& decode_source, const SampleChunkCallback& on_samples, size_t chunk_frames = 256, size_t context_frames = 32);
+
+    //==============================================================================
+    // Opt in, while set every model and synthesis call above is written to the recorder. Pass nullptr to stop recording.
+    // NOTE: getMetasJson, isModelLoaded and getSampleRate only query the core state and are not recorded.
+    //       singBySfDecodeStreaming is recorded as SingBySfDecode, see VoicevoxTraceRecorder.
+    void setTraceRecorder(std::shared_ptr<VoicevoxTraceRecorder> recorder);
+
 private:
     //==============================================================================
+    SharedVoicevoxEventLogDrain sharedEventLogDrain;
     std::atomic<bool> isConnected_;
     std::unique_ptr<voicevox::SharedVoicevoxCoreHost> sharedVoicevoxCoreHost;
 
+    juce::Result decodeStreaming(juce::uint32 speaker_id, const VoicevoxSfDecodeSource& decode_source, const SampleChunkCallback& on_samples, size_t chunk_frames, size_t context_frames);
+    std::shared_ptr<VoicevoxTraceRecorder> getTraceRecorder() const;
+
+    // NOTE: Calls may run on any thread, each one takes a copy of the pointer under the lock.
+    mutable juce::SpinLock traceRecorderLock;
+    std::shared_ptr<VoicevoxTraceRecorder> traceRecorder;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VoicevoxClient)
 };
 
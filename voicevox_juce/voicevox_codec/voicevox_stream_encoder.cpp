@@ -0,0 +1,486 @@
+#include "voicevox_stream_encoder.h"
+#include "../voicevox_client/voicevox_client.h"
+#include "../voicevox_dsp/voicevox_audio_kernels.h"
+#include "../voicevox_threading/voicevox_thread_placement.h"
+
+namespace voicevox
+{
+
+namespace
+{
+    // libFLAC default compression level.
+    constexpr int defaultFlacQualityOptionIndex = 5;
+
+    // Vorbis quality 0.4, transparent enough for 24kHz mono speech.
+    constexpr int defaultOggVorbisQualityOptionIndex = 4;
+
+    constexpr int wavReadBlockSamples = 8192;
+    constexpr int maxEncodeBlockSamples = 65536;
+}
+
+//==============================================================================
+/** Forwards to the given stream and keeps track of the compressed size. */
+class VoicevoxStreamEncoder::CountingOutputStream final
+    : public juce::OutputStream
+{
+public:
+    CountingOutputStream(std::unique_ptr<juce::OutputStream> target_stream, std::atomic<juce::uint64>& num_bytes_written)
+        : targetStream(std::move(target_stream))
+        , numBytesWritten(num_bytes_written)
+        , position(targetStream->getPosition())
+    {
+    }
+
+    void flush() override
+    {
+        targetStream->flush();
+    }
+
+    bool setPosition(juce::int64 new_position) override
+    {
+        // NOTE: FLAC seeks back to rewrite its header when finished.
+        if (!targetStream->setPosition(new_position))
+        {
+            return false;
+        }
+
+        position = new_position;
+        return true;
+    }
+
+    juce::int64 getPosition() override
+    {
+        return position;
+    }
+
+    bool write(const void* data, size_t num_bytes) override
+    {
+        if (!targetStream->write(data, num_bytes))
+        {
+            return false;
+        }
+
+        advance(num_bytes);
+        return true;
+    }
+
+    bool writeRepeatedByte(juce::uint8 byte, size_t num_times_to_repeat) override
+    {
+        if (!targetStream->writeRepeatedByte(byte, num_times_to_repeat))
+        {
+            return false;
+        }
+
+        advance(num_times_to_repeat);
+        return true;
+    }
+
+private:
+    void advance(size_t num_bytes)
+    {
+        position += (juce::int64)num_bytes;
+
+        if ((juce::uint64)position > numBytesWritten.load(std::memory_order_relaxed))
+        {
+            numBytesWritten.store((juce::uint64)position, std::memory_order_relaxed);
+        }
+    }
+
+    std::unique_ptr<juce::OutputStream> targetStream;
+    std::atomic<juce::uint64>& numBytesWritten;
+    juce::int64 position;
+};
+
+//==============================================================================
+class VoicevoxStreamEncoder::EncoderThread final
+    : public juce::Thread
+{
+public:
+    explicit EncoderThread(VoicevoxStreamEncoder& owner_to_use)
+        : juce::Thread("voicevox_stream_encoder")
+        , owner(owner_to_use)
+    {
+    }
+
+    ~EncoderThread() override
+    {
+        // NOTE: Never time out, run() has to drain the queue before the writer is finalized.
+        stopThread(-1);
+    }
+
+    void run() override
+    {
+        VoicevoxThreadPlacement::applyWorkerAffinity();
+
+        while (!threadShouldExit())
+        {
+            owner.queueDataAvailable.wait(50);
+            owner.drainQueue();
+        }
+
+        owner.drainQueue();
+    }
+
+private:
+    VoicevoxStreamEncoder& owner;
+};
+
+//==============================================================================
+VoicevoxStreamEncoder::VoicevoxStreamEncoder()
+    : audioFormatWriter(nullptr)
+    , hasEncodeFailed(false)
+    , numSamplesEncoded(0)
+    , numBytesWritten(0)
+    , encodeTicks(0)
+{
+}
+
+VoicevoxStreamEncoder::~VoicevoxStreamEncoder()
+{
+    finish();
+}
+
+//==============================================================================
+juce::Result VoicevoxStreamEncoder::open(std::unique_ptr<juce::OutputStream> output_stream, const VoicevoxStreamEncoderOptions& options)
+{
+    finish();
+
+    if (output_stream == nullptr)
+    {
+        return juce::Result::fail("No output stream");
+    }
+
+    std::unique_ptr<juce::AudioFormat> audio_format;
+    int bits_per_sample = options.bitsPerSample;
+    int quality_option_index = options.qualityOptionIndex;
+
+    switch (options.format)
+    {
+    case VoicevoxEncodeFormat::Flac:
+#if JUCE_USE_FLAC
+        audio_format = std::make_unique<juce::FlacAudioFormat>();
+#endif
+        quality_option_index = quality_option_index >= 0 ? quality_option_index : defaultFlacQualityOptionIndex;
+        break;
+
+    case VoicevoxEncodeFormat::OggVorbis:
+#if JUCE_USE_OGGVORBIS
+        audio_format = std::make_unique<juce::OggVorbisAudioFormat>();
+#endif
+        // NOTE: Vorbis always encodes floating point samples.
+        bits_per_sample = 32;
+        quality_option_index = quality_option_index >= 0 ? quality_option_index : defaultOggVorbisQualityOptionIndex;
+        break;
+
+    default:
+        break;
+    }
+
+    if (audio_format == nullptr)
+    {
+        return juce::Result::fail("Format is not enabled in juce_audio_formats");
+    }
+
+    numSamplesEncoded = 0;
+    numBytesWritten = 0;
+    encodeTicks = 0;
+    hasEncodeFailed = false;
+
+    auto counting_output_stream = std::make_unique<CountingOutputStream>(std::move(output_stream), numBytesWritten);
+
+    audioFormatWriter.reset(audio_format->createWriterFor(counting_output_stream.get(), options.sampleRate, 1, bits_per_sample, {}, quality_option_index));
+    if (audioFormatWriter == nullptr)
+    {
+        return juce::Result::fail("Failed to create " + audio_format->getFormatName() + " writer");
+    }
+
+    // NOTE: The writer owns the stream from now on.
+    counting_output_stream.release();
+
+    if (!audioFormatWriter->isFloatingPoint())
+    {
+        fixedPointBuffer.assign((size_t)maxEncodeBlockSamples, 0);
+    }
+
+    if (options.backgroundQueueSamples > 0)
+    {
+        queueBuffer.assign((size_t)options.backgroundQueueSamples, 0.0f);
+        queueFifo = std::make_unique<juce::AbstractFifo>(options.backgroundQueueSamples);
+
+        encoderThread = std::make_unique<EncoderThread>(*this);
+        encoderThread->startThread();
+    }
+
+    return juce::Result::ok();
+}
+
+bool VoicevoxStreamEncoder::isOpen() const noexcept
+{
+    return audioFormatWriter != nullptr;
+}
+
+//==============================================================================
+bool VoicevoxStreamEncoder::write(const float* samples, size_t num_samples)
+{
+    if (!isOpen() || hasEncodeFailed)
+    {
+        return false;
+    }
+
+    if (encoderThread == nullptr)
+    {
+        while (num_samples > 0)
+        {
+            const auto num_to_encode = (int)std::min<size_t>(num_samples, maxEncodeBlockSamples);
+            if (!encode(samples, num_to_encode))
+            {
+                return false;
+            }
+
+            samples += num_to_encode;
+            num_samples -= (size_t)num_to_encode;
+        }
+
+        return true;
+    }
+
+    while (num_samples > 0)
+    {
+        const auto num_to_queue = (int)std::min<size_t>(num_samples, (size_t)queueFifo->getFreeSpace());
+        if (num_to_queue == 0)
+        {
+            queueSpaceAvailable.wait(50);
+
+            if (hasEncodeFailed)
+            {
+                return false;
+            }
+            continue;
+        }
+
+        {
+            const auto scope = queueFifo->write(num_to_queue);
+            std::copy(samples, samples + scope.blockSize1, queueBuffer.data() + scope.startIndex1);
+            std::copy(samples + scope.blockSize1, samples + scope.blockSize1 + scope.blockSize2, queueBuffer.data() + scope.startIndex2);
+        }
+
+        queueDataAvailable.signal();
+
+        samples += num_to_queue;
+        num_samples -= (size_t)num_to_queue;
+    }
+
+    return !hasEncodeFailed;
+}
+
+juce::Result VoicevoxStreamEncoder::writeWav(const std::vector<std::byte>& wav_data)
+{
+    if (!isOpen())
+    {
+        return juce::Result::fail("Encoder is not open");
+    }
+
+    juce::WavAudioFormat wav_format;
+    std::unique_ptr<juce::AudioFormatReader> reader(wav_format.createReaderFor(new juce::MemoryInputStream(wav_data.data(), wav_data.size(), false), true));
+    if (reader == nullptr)
+    {
+        return juce::Result::fail("Invalid WAV data");
+    }
+
+    if (reader->numChannels != 1)
+    {
+        return juce::Result::fail("Only mono WAV is supported");
+    }
+
+    if (reader->sampleRate != audioFormatWriter->getSampleRate())
+    {
+        return juce::Result::fail("Sample rate of WAV data does not match the encoder");
+    }
+
+    juce::AudioBuffer<float> block(1, wavReadBlockSamples);
+
+    for (juce::int64 position = 0; position < reader->lengthInSamples; position += wavReadBlockSamples)
+    {
+        const auto num_samples = (int)std::min<juce::int64>(wavReadBlockSamples, reader->lengthInSamples - position);
+
+        if (!reader->read(&block, 0, num_samples, position, true, false))
+        {
+            return juce::Result::fail("Failed to read WAV data");
+        }
+
+        if (!write(block.getReadPointer(0), (size_t)num_samples))
+        {
+            return juce::Result::fail("Failed to encode");
+        }
+    }
+
+    return juce::Result::ok();
+}
+
+juce::Result VoicevoxStreamEncoder::writeSong(VoicevoxClient& client, juce::uint32 speaker_id, const VoicevoxSfDecodeSource& decode_source, size_t chunk_frames, size_t context_frames)
+{
+    if (!isOpen())
+    {
+        return juce::Result::fail("Encoder is not open");
+    }
+
+    // NOTE: sf_decode_forward function is processed under 24kHz due to hard coded in core library.
+    if (audioFormatWriter->getSampleRate() != 24000.0)
+    {
+        return juce::Result::fail("Song output is 24kHz, open the encoder with the same sample rate");
+    }
+
+    const auto result = client.singBySfDecodeStreaming(speaker_id, decode_source,
+        [this](const float* samples, size_t num_samples) { return write(samples, num_samples); },
+        chunk_frames, context_frames);
+
+    if (hasEncodeFailed)
+    {
+        return juce::Result::fail("Failed to encode");
+    }
+
+    return result;
+}
+
+juce::Result VoicevoxStreamEncoder::finish()
+{
+    if (!isOpen())
+    {
+        return juce::Result::ok();
+    }
+
+    if (encoderThread != nullptr)
+    {
+        encoderThread->signalThreadShouldExit();
+        queueDataAvailable.signal();
+        encoderThread.reset();
+
+        queueFifo.reset();
+        queueBuffer = std::vector<float>();
+    }
+
+    // NOTE: Destroying the writer flushes the encoder and finalizes the stream.
+    audioFormatWriter.reset();
+    fixedPointBuffer = std::vector<int>();
+
+    if (hasEncodeFailed)
+    {
+        return juce::Result::fail("Failed to encode");
+    }
+
+    return juce::Result::ok();
+}
+
+//==============================================================================
+VoicevoxStreamEncoder::Statistics VoicevoxStreamEncoder::getStatistics() const noexcept
+{
+    Statistics statistics;
+    statistics.numSamplesEncoded = numSamplesEncoded.load();
+    statistics.numBytesWritten = numBytesWritten.load();
+    statistics.encodeSeconds = juce::Time::highResolutionTicksToSeconds(encodeTicks.load());
+
+    return statistics;
+}
+
+const char* VoicevoxStreamEncoder::getFileExtension(VoicevoxEncodeFormat format) noexcept
+{
+    switch (format)
+    {
+    case VoicevoxEncodeFormat::Flac:      return ".flac";
+    case VoicevoxEncodeFormat::OggVorbis: return ".ogg";
+    default:                              return "";
+    }
+}
+
+std::optional<VoicevoxEncodeMeasurement> VoicevoxStreamEncoder::measure(const float* samples, size_t num_samples, const VoicevoxStreamEncoderOptions& options)
+{
+    auto measure_options = options;
+    measure_options.backgroundQueueSamples = 0;
+
+    VoicevoxStreamEncoder encoder;
+
+    const auto start_ticks = juce::Time::getHighResolutionTicks();
+
+    if (encoder.open(std::make_unique<juce::MemoryOutputStream>(), measure_options).failed()
+        || !encoder.write(samples, num_samples)
+        || encoder.finish().failed())
+    {
+        return std::nullopt;
+    }
+
+    const auto elapsed_seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start_ticks);
+    const auto statistics = encoder.getStatistics();
+
+    VoicevoxEncodeMeasurement measurement;
+    measurement.numSamples = statistics.numSamplesEncoded;
+    measurement.numBytes = statistics.numBytesWritten;
+    measurement.compressionRatio = statistics.numBytesWritten > 0 ? (double)(statistics.numSamplesEncoded * 2) / (double)statistics.numBytesWritten : 0.0;
+    measurement.encodeSeconds = elapsed_seconds;
+    measurement.speedFactor = elapsed_seconds > 0.0 ? (double)num_samples / measure_options.sampleRate / elapsed_seconds : 0.0;
+
+    return measurement;
+}
+
+//==============================================================================
+bool VoicevoxStreamEncoder::encode(const float* samples, int num_samples)
+{
+    const auto start_ticks = juce::Time::getHighResolutionTicks();
+    auto is_success = true;
+
+    if (fixedPointBuffer.empty())
+    {
+        is_success = audioFormatWriter->writeFromFloatArrays(&samples, 1, num_samples);
+    }
+    else
+    {
+        // NOTE: Converted with the vectorized kernels instead of the per sample converter of writeFromFloatArrays().
+        const auto bits_per_sample = audioFormatWriter->getBitsPerSample();
+        const int* channels[] = { fixedPointBuffer.data(), nullptr };
+
+        for (int offset = 0; is_success && offset < num_samples; offset += maxEncodeBlockSamples)
+        {
+            const auto num_to_convert = std::min(num_samples - offset, maxEncodeBlockSamples);
+            VoicevoxAudioKernels::convertToInt32(samples + offset, fixedPointBuffer.data(), (size_t)num_to_convert, bits_per_sample);
+            is_success = audioFormatWriter->write(channels, num_to_convert);
+        }
+    }
+
+    encodeTicks += juce::Time::getHighResolutionTicks() - start_ticks;
+
+    if (!is_success)
+    {
+        hasEncodeFailed = true;
+        return false;
+    }
+
+    numSamplesEncoded += (juce::uint64)num_samples;
+    return true;
+}
+
+void VoicevoxStreamEncoder::drainQueue()
+{
+    const auto num_ready = queueFifo->getNumReady();
+    if (num_ready == 0)
+    {
+        return;
+    }
+
+    {
+        const auto scope = queueFifo->read(num_ready);
+
+        // NOTE: Keep consuming after a failure, so that a blocked writer never waits forever.
+        if (!hasEncodeFailed && scope.blockSize1 > 0)
+        {
+            encode(queueBuffer.data() + scope.startIndex1, scope.blockSize1);
+        }
+
+        if (!hasEncodeFailed && scope.blockSize2 > 0)
+        {
+            encode(queueBuffer.data() + scope.startIndex2, scope.blockSize2);
+        }
+    }
+
+    queueSpaceAvailable.signal();
+}
+
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+
+namespace voicevox
+{
+
+class VoicevoxClient;
+struct VoicevoxSfDecodeSource;
+
+//==============================================================================
+enum class VoicevoxEncodeFormat
+{
+    Flac = 0,
+    OggVorbis
+};
+
+struct VoicevoxStreamEncoderOptions
+{
+    VoicevoxEncodeFormat format{ VoicevoxEncodeFormat::Flac };
+    double sampleRate{ 24000.0 };
+
+    // FLAC only, 16 or 24.
+    int bitsPerSample{ 16 };
+
+    // Index into getQualityOptions() of the format, -1 uses the default of the format.
+    int qualityOptionIndex{ -1 };
+
+    // Capacity of the queue drained by a background encoder thread, 0 encodes on the calling thread.
+    int backgroundQueueSamples{ 0 };
+};
+
+struct VoicevoxEncodeMeasurement
+{
+    juce::uint64 numSamples{ 0 };
+    juce::uint64 numBytes{ 0 };
+
+    // Size of the same samples as 16 bit PCM, which synthesis() returns, divided by numBytes.
+    double compressionRatio{ 0.0 };
+
+    // Includes finalizing the stream.
+    double encodeSeconds{ 0.0 };
+
+    // Seconds of audio encoded per second of encode time.
+    double speedFactor{ 0.0 };
+};
+
+//==============================================================================
+/**
+    Encodes mono rendered audio to FLAC or Ogg Vorbis block by block.
+
+    Samples are compressed as they are written, so a full uncompressed render
+    never has to be kept. writeSong() feeds the chunked sf_decode_forward of
+    VoicevoxClient straight into the encoder, and with a background queue the
+    encoding of one chunk overlaps the inference of the next one.
+*/
+class VoicevoxStreamEncoder final
+{
+public:
+    //==============================================================================
+    struct Statistics
+    {
+        juce::uint64 numSamplesEncoded{ 0 };
+        juce::uint64 numBytesWritten{ 0 };
+        double encodeSeconds{ 0.0 };
+    };
+
+    //==============================================================================
+    VoicevoxStreamEncoder();
+    ~VoicevoxStreamEncoder();
+
+    //==============================================================================
+    juce::Result open(std::unique_ptr<juce::OutputStream> output_stream, const VoicevoxStreamEncoderOptions& options = {});
+    bool isOpen() const noexcept;
+
+    // Mono samples in the range [-1, 1], blocks while the background queue is full.
+    bool write(const float* samples, size_t num_samples);
+
+    // Re-encodes the WAV returned by synthesis() or tts() without converting it to float at once.
+    juce::Result writeWav(const std::vector<std::byte>& wav_data);
+
+    juce::Result writeSong(VoicevoxClient& client, juce::uint32 speaker_id, const VoicevoxSfDecodeSource& decode_source, size_t chunk_frames = 256, size_t context_frames = 32);
+
+    // Encodes everything queued and finalizes the stream, also done by the destructor.
+    juce::Result finish();
+
+    //==============================================================================
+    Statistics getStatistics() const noexcept;
+
+    static const char* getFileExtension(VoicevoxEncodeFormat format) noexcept;
+
+    // Encodes the samples into memory on the calling thread, for throughput and compression ratio of a format.
+    static std::optional<VoicevoxEncodeMeasurement> measure(const float* samples, size_t num_samples, const VoicevoxStreamEncoderOptions& options = {});
+
+private:
+    //==============================================================================
+    class CountingOutputStream;
+    class EncoderThread;
+
+    bool encode(const float* samples, int num_samples);
+    void drainQueue();
+
+    //==============================================================================
+    std::unique_ptr<juce::AudioFormatWriter> audioFormatWriter;
+    std::atomic<bool> hasEncodeFailed;
+
+    // Left-justified samples for integer formats, empty for floating point ones.
+    std::vector<int> fixedPointBuffer;
+
+    std::unique_ptr<juce::AbstractFifo> queueFifo;
+    std::vector<float> queueBuffer;
+    juce::WaitableEvent queueDataAvailable;
+    juce::WaitableEvent queueSpaceAvailable;
+    std::unique_ptr<EncoderThread> encoderThread;
+
+    std::atomic<juce::uint64> numSamplesEncoded;
+    std::atomic<juce::uint64> numBytesWritten;
+    std::atomic<juce::int64> encodeTicks;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VoicevoxStreamEncoder)
+};
+
+}
@@ -1,5 +1,6 @@
 ﻿#include "voicevox_core_host.h"
 #include "voicevox_core.h"
+#include "../voicevox_log/voicevox_event_log.h"
 
 namespace voicevox
 {
@@ -76,11 +77,28 @@ VoicevoxCoreHost::VoicevoxCoreHost()
     const auto str_jtalk_dict_dir = jtalk_dict_dir.toStdString();
     options.open_jtalk_dict_dir = str_jtalk_dict_dir.c_str();
 
+    const auto num_inference_threads = VoicevoxThreadPlacement::getNumInferenceThreads();
+    if (num_inference_threads > 0)
+    {
+        options.cpu_num_threads = (uint16_t)std::min(num_inference_threads, 65535);
+    }
+
+    // NOTE: ONNX runtime threads inherit the affinity of the thread creating them. Sessions are created lazily in
+    //       voicevox_load_model() unless load_all_models is set, so loadModel() pins the calling thread as well.
+    //       Threads calling into the core pin themselves with VoicevoxThreadPlacement::applyInferenceAffinity().
+    VoicevoxScopedThreadAffinity inference_affinity(VoicevoxThreadPlacement::getOptions().inferenceCpus);
+
     VoicevoxResultCode result = voicevox_initialize(options);
 
     if (result != VoicevoxResultCode::VOICEVOX_RESULT_OK) {
-        const char* utf8Str = voicevox_error_result_to_message(result);
-        juce::Logger::outputDebugString(juce::CharPointer_UTF8(utf8Str));
+        VoicevoxEventLog::log(VoicevoxLogLevel::Error, VoicevoxEventId::CoreInitialize, 0, (juce::int32)result);
+
+        // NOTE: Log records carry no text, the message is written once here as it only happens at start up.
+        if (VoicevoxEventLog::getInstance().shouldLog(VoicevoxLogLevel::Error))
+        {
+            const char* utf8Str = voicevox_error_result_to_message(result);
+            juce::Logger::writeToLog("[voicevox_juce] voicevox_initialize failed: " + juce::String(juce::CharPointer_UTF8(utf8Str)));
+        }
     }
 
     isInitialized = true;
@@ -143,16 +161,20 @@ juce::Result VoicevoxCoreHost::loadModel(juce::uint32 speaker_id)
 {
     jassert(sharedVoicevoxCoreLibrary->isHandled());
 
+    VoicevoxScopedEventTimer event_timer(VoicevoxEventId::LoadModel, speaker_id);
+    VoicevoxScopedThreadAffinity inference_affinity(VoicevoxThreadPlacement::getOptions().inferenceCpus);
+
     try {
         VoicevoxResultCode result = voicevox_load_model(speaker_id);
         
         if (result != VoicevoxResultCode::VOICEVOX_RESULT_OK) {
             const char* utf8Str = voicevox_error_result_to_message(result);
-            juce::Logger::outputDebugString(juce::CharPointer_UTF8(utf8Str));
+            event_timer.setResultCode((juce::int32)result);
             return juce::Result::fail(juce::CharPointer_UTF8(utf8Str));
         }
     }
     catch (std::exception e) {
+        event_timer.setResultCode(VoicevoxEventLog::resultFunctionFailure);
         return juce::Result::fail(e.what());
     }
 
@@ -178,6 +200,8 @@ std::optional<juce::String> VoicevoxCoreHost::makeAudioQuery(juce::uint32 speake
 {
     jassert(sharedVoicevoxCoreLibrary->isHandled());
 
+    VoicevoxScopedEventTimer event_timer(VoicevoxEventId::AudioQuery, speaker_id);
+
     char* output_audio_query_json;
 
     VoicevoxAudioQueryOptions audio_query_options = voicevox_make_default_audio_query_options();
@@ -185,8 +209,7 @@ std::optional<juce::String> VoicevoxCoreHost::makeAudioQuery(juce::uint32 speake
     VoicevoxResultCode result = voicevox_audio_query(speak_words.toRawUTF8(), (uint32_t)speaker_id, audio_query_options, &output_audio_query_json);
 
     if (result != VoicevoxResultCode::VOICEVOX_RESULT_OK) {
-        const char* utf8Str = voicevox_error_result_to_message(result);
-        juce::Logger::outputDebugString(juce::CharPointer_UTF8(utf8Str));
+        event_timer.setResultCode((juce::int32)result);
         return std::nullopt;
     }
 
@@ -203,6 +226,8 @@ std::optional<std::vector<std::byte>> VoicevoxCoreHost::synthesis(juce::uint32 s
 
     jassert(sharedVoicevoxCoreLibrary->isHandled());
 
+    VoicevoxScopedEventTimer event_timer(VoicevoxEventId::Synthesis, speaker_id);
+
     VoicevoxSynthesisOptions synthesis_options = voicevox_make_default_synthesis_options();
 
     uintptr_t output_binary_size = 0;
@@ -211,8 +236,7 @@ std::optional<std::vector<std::byte>> VoicevoxCoreHost::synthesis(juce::uint32 s
     VoicevoxResultCode result = voicevox_synthesis(audio_query_json.toRawUTF8(), (uint32_t)speaker_id, synthesis_options, &output_binary_size, &output_wav);
 
     if (result != VoicevoxResultCode::VOICEVOX_RESULT_OK) {
-        const char* utf8Str = voicevox_error_result_to_message(result);
-        juce::Logger::outputDebugString(juce::CharPointer_UTF8(utf8Str));
+        event_timer.setResultCode((juce::int32)result);
         return std::nullopt;
     }
 
@@ -229,6 +253,8 @@ std::optional<std::vector<std::byte>> VoicevoxCoreHost::tts(juce::uint32 speaker
 
     jassert(sharedVoicevoxCoreLibrary->isHandled());
 
+    VoicevoxScopedEventTimer event_timer(VoicevoxEventId::Tts, speaker_id);
+
     VoicevoxTtsOptions tts_options = voicevox_make_default_tts_options();
 
     uintptr_t output_binary_size = 0;
@@ -237,8 +263,7 @@ std::optional<std::vector<std::byte>> VoicevoxCoreHost::tts(juce::uint32 speaker
     VoicevoxResultCode result = voicevox_tts(speak_words.toRawUTF8(), (uint32_t)speaker_id, tts_options, &output_binary_size, &output_wav);
 
     if (result != VoicevoxResultCode::VOICEVOX_RESULT_OK) {
-        const char* utf8Str = voicevox_error_result_to_message(result);
-        juce::Logger::outputDebugString(juce::CharPointer_UTF8(utf8Str));
+        event_timer.setResultCode((juce::int32)result);
         return std::nullopt;
     }
 
@@ -263,32 +288,54 @@ pub extern "C" fn predict_sing_consonant_length_forward(
 */
 using voicevox_predict_sing_consonant_length_forward = bool(*) (int64_t /*length*/, int64_t* /*consonant*/, int64_t* /*vowel*/, int64_t* /*note_duration*/, int64_t* /*speaker_id*/, int64_t* /*output*/);
 
-std::optional<std::vector<std::int64_t>> VoicevoxCoreHost::predict_sing_consonant_length_forward(juce::uint32 speaker_id, std::vector<std::int64_t> consonant, std::vector<std::int64_t> vowel, std::vector<std::int64_t> note_duration)
+std::optional<std::vector<std::int64_t>> VoicevoxCoreHost::predict_sing_consonant_length_forward(juce::uint32 speaker_id, const std::vector<std::int64_t>& consonant, const std::vector<std::int64_t>& vowel, const std::vector<std::int64_t>& note_duration)
+{
+    std::vector<std::int64_t> output_data(consonant.size());
+
+    if (!invoke_predict_sing_consonant_length_forward(speaker_id, consonant.size(), consonant.data(), vowel.data(), note_duration.data(), output_data.data()))
+    {
+        return std::nullopt;
+    }
+
+    return output_data;
+}
+
+std::optional<VoicevoxFrameSpan<std::int64_t>> VoicevoxCoreHost::predict_sing_consonant_length_forward(VoicevoxFrameArena& arena, juce::uint32 speaker_id, VoicevoxFrameSpan<const std::int64_t> consonant, VoicevoxFrameSpan<const std::int64_t> vowel, VoicevoxFrameSpan<const std::int64_t> note_duration)
+{
+    auto output_data = arena.allocate<std::int64_t>(consonant.size());
+
+    if (!invoke_predict_sing_consonant_length_forward(speaker_id, consonant.size(), consonant.data(), vowel.data(), note_duration.data(), output_data.data()))
+    {
+        return std::nullopt;
+    }
+
+    return output_data;
+}
+
+bool VoicevoxCoreHost::invoke_predict_sing_consonant_length_forward(juce::uint32 speaker_id, size_t length, const std::int64_t* consonant, const std::int64_t* vowel, const std::int64_t* note_duration, std::int64_t* output)
 {
     jassert(sharedVoicevoxCoreLibrary->isHandled());
 
     int64_t speaker_id_i64 = speaker_id;
 
-    uintptr_t output_data_length = consonant.size();
-
-    juce::HeapBlock<std::int64_t> output_data;
-    output_data.malloc(output_data_length);
+    VoicevoxScopedEventTimer event_timer(VoicevoxEventId::PredictSingConsonantLength, speaker_id);
 
     const auto function_predict_sing_consonant_length_forward = (voicevox_predict_sing_consonant_length_forward)sharedVoicevoxCoreLibrary->getDynamicLibrary()->getFunction("predict_sing_consonant_length_forward");
     if (function_predict_sing_consonant_length_forward == nullptr)
     {
-        juce::Logger::outputDebugString(juce::CharPointer_UTF8("[voicevox_juce] predict_sing_consonant_length_forward function is not found."));
-        return std::nullopt;
+        event_timer.setResultCode(VoicevoxEventLog::resultFunctionNotFound);
+        return false;
     }
 
-    const auto is_success = function_predict_sing_consonant_length_forward(consonant.size(), consonant.data(), vowel.data(), note_duration.data(), &speaker_id_i64, output_data.getData());
+    // NOTE: Core library takes mutable pointers, but never writes to input arrays.
+    const auto is_success = function_predict_sing_consonant_length_forward((int64_t)length, const_cast<int64_t*>(consonant), const_cast<int64_t*>(vowel), const_cast<int64_t*>(note_duration), &speaker_id_i64, output);
     if (!is_success)
     {
-        juce::Logger::outputDebugString(juce::CharPointer_UTF8("[voicevox_juce] predict_sing_consonant_length_forward function is failure."));
-        return std::nullopt;
+        event_timer.setResultCode(VoicevoxEventLog::resultFunctionFailure);
+        return false;
     }
 
-    return std::vector<std::int64_t>(output_data.getData(), output_data.getData() + output_data_length);
+    return true;
 }
 
 /**
@@ -303,32 +350,53 @@ pub extern "C" fn predict_sing_f0_forward(
 */
 using voicevox_predict_sing_f0_forward = bool(*) (int64_t /*length*/, int64_t* /*phoneme*/, int64_t* /*note*/, int64_t* /*speaker_id*/, float* /*output*/);
 
-std::optional<std::vector<float>> VoicevoxCoreHost::predict_sing_f0_forward(juce::uint32 speaker_id, std::vector<std::int64_t> phoneme, std::vector<std::int64_t> note)
+std::optional<std::vector<float>> VoicevoxCoreHost::predict_sing_f0_forward(juce::uint32 speaker_id, const std::vector<std::int64_t>& phoneme, const std::vector<std::int64_t>& note)
+{
+    std::vector<float> output_data(phoneme.size());
+
+    if (!invoke_predict_sing_f0_forward(speaker_id, phoneme.size(), phoneme.data(), note.data(), output_data.data()))
+    {
+        return std::nullopt;
+    }
+
+    return output_data;
+}
+
+std::optional<VoicevoxFrameSpan<float>> VoicevoxCoreHost::predict_sing_f0_forward(VoicevoxFrameArena& arena, juce::uint32 speaker_id, VoicevoxFrameSpan<const std::int64_t> phoneme, VoicevoxFrameSpan<const std::int64_t> note)
+{
+    auto output_data = arena.allocate<float>(phoneme.size());
+
+    if (!invoke_predict_sing_f0_forward(speaker_id, phoneme.size(), phoneme.data(), note.data(), output_data.data()))
+    {
+        return std::nullopt;
+    }
+
+    return output_data;
+}
+
+bool VoicevoxCoreHost::invoke_predict_sing_f0_forward(juce::uint32 speaker_id, size_t length, const std::int64_t* phoneme, const std::int64_t* note, float* output)
 {
     jassert(sharedVoicevoxCoreLibrary->isHandled());
 
     int64_t speaker_id_i64 = speaker_id;
 
-    uintptr_t output_data_length = phoneme.size();
-
-    juce::HeapBlock<float> output_data;
-    output_data.malloc(output_data_length);
+    VoicevoxScopedEventTimer event_timer(VoicevoxEventId::PredictSingF0, speaker_id);
 
     const auto function_predict_sing_f0_forward = (voicevox_predict_sing_f0_forward)sharedVoicevoxCoreLibrary->getDynamicLibrary()->getFunction("predict_sing_f0_forward");
     if (function_predict_sing_f0_forward == nullptr)
     {
-        juce::Logger::outputDebugString(juce::CharPointer_UTF8("[voicevox_juce] predict_sing_f0_forward function is not found."));
-        return std::nullopt;
+        event_timer.setResultCode(VoicevoxEventLog::resultFunctionNotFound);
+        return false;
     }
 
-    const auto is_success = function_predict_sing_f0_forward(phoneme.size(), phoneme.data(), note.data(), &speaker_id_i64, output_data.getData());
+    const auto is_success = function_predict_sing_f0_forward((int64_t)length, const_cast<int64_t*>(phoneme), const_cast<int64_t*>(note), &speaker_id_i64, output);
     if (!is_success)
     {
-        juce::Logger::outputDebugString(juce::CharPointer_UTF8("[voicevox_juce] predict_sing_f0_forward function is failure."));
-        return std::nullopt;
+        event_timer.setResultCode(VoicevoxEventLog::resultFunctionFailure);
+        return false;
     }
 
-    return std::vector<float>(output_data.getData(), output_data.getData() + output_data_length);
+    return true;
 }
 
 /**
@@ -344,32 +412,53 @@ pub extern "C" fn predict_sing_volume_forward(
 */
 using voicevox_predict_sing_volume_forward = bool(*) (int64_t /*length*/, int64_t* /*phoneme*/, int64_t* /*note*/, float* /*f0*/, int64_t* /*speaker_id*/, float* /*output*/);
 
-std::optional<std::vector<float>> VoicevoxCoreHost::predict_sing_volume_forward(juce::uint32 speaker_id, std::vector<std::int64_t> phoneme, std::vector<std::int64_t> note, std::vector<float> f0)
+std::optional<std::vector<float>> VoicevoxCoreHost::predict_sing_volume_forward(juce::uint32 speaker_id, const std::vector<std::int64_t>& phoneme, const std::vector<std::int64_t>& note, const std::vector<float>& f0)
+{
+    std::vector<float> output_data(phoneme.size());
+
+    if (!invoke_predict_sing_volume_forward(speaker_id, phoneme.size(), phoneme.data(), note.data(), f0.data(), output_data.data()))
+    {
+        return std::nullopt;
+    }
+
+    return output_data;
+}
+
+std::optional<VoicevoxFrameSpan<float>> VoicevoxCoreHost::predict_sing_volume_forward(VoicevoxFrameArena& arena, juce::uint32 speaker_id, VoicevoxFrameSpan<const std::int64_t> phoneme, VoicevoxFrameSpan<const std::int64_t> note, VoicevoxFrameSpan<const float> f0)
+{
+    auto output_data = arena.allocate<float>(phoneme.size());
+
+    if (!invoke_predict_sing_volume_forward(speaker_id, phoneme.size(), phoneme.data(), note.data(), f0.data(), output_data.data()))
+    {
+        return std::nullopt;
+    }
+
+    return output_data;
+}
+
+bool VoicevoxCoreHost::invoke_predict_sing_volume_forward(juce::uint32 speaker_id, size_t length, const std::int64_t* phoneme, const std::int64_t* note, const float* f0, float* output)
 {
     jassert(sharedVoicevoxCoreLibrary->isHandled());
-    
-    int64_t speaker_id_i64 = speaker_id;
 
-    uintptr_t output_data_length = phoneme.size();
+    int64_t speaker_id_i64 = speaker_id;
 
-    juce::HeapBlock<float> output_data;
-    output_data.malloc(output_data_length);
+    VoicevoxScopedEventTimer event_timer(VoicevoxEventId::PredictSingVolume, speaker_id);
 
     const auto function_predict_sing_volume_forward = (voicevox_predict_sing_volume_forward)sharedVoicevoxCoreLibrary->getDynamicLibrary()->getFunction("predict_sing_volume_forward");
     if (function_predict_sing_volume_forward == nullptr)
     {
-        juce::Logger::outputDebugString(juce::CharPointer_UTF8("[voicevox_juce] predict_sing_volume_forward function is not found."));
-        return std::nullopt;
+        event_timer.setResultCode(VoicevoxEventLog::resultFunctionNotFound);
+        return false;
     }
 
-    const auto is_success = function_predict_sing_volume_forward(phoneme.size(), phoneme.data(), note.data(), f0 .data(), & speaker_id_i64, output_data.getData());
+    const auto is_success = function_predict_sing_volume_forward((int64_t)length, const_cast<int64_t*>(phoneme), const_cast<int64_t*>(note), const_cast<float*>(f0), &speaker_id_i64, output);
     if (!is_success)
     {
-        juce::Logger::outputDebugString(juce::CharPointer_UTF8("[voicevox_juce] predict_sing_volume_forward function is failure."));
-        return std::nullopt;
+        event_timer.setResultCode(VoicevoxEventLog::resultFunctionFailure);
+        return false;
     }
 
-    return std::vector<float>(output_data.getData(), output_data.getData() + output_data_length);
+    return true;
 }
 
 /**
@@ -384,33 +473,54 @@ pub extern "C" fn sf_decode_forward(
 */
 using voicevox_sf_decode_forward = bool(*) (int64_t /*length*/, int64_t* /*phoneme*/, float* /*f0*/, float* /*volume*/, int64_t* /*speaker_id*/, float* /*output*/);
 
-std::optional<std::vector<float>> VoicevoxCoreHost::sf_decode_forward(juce::uint32 speaker_id, std::vector<std::int64_t> phoneme_vector, std::vector<float> f0_vector, std::vector<float> volume_vector)
+std::optional<std::vector<float>> VoicevoxCoreHost::sf_decode_forward(juce::uint32 speaker_id, const std::vector<std::int64_t>& phoneme_vector, const std::vector<float>& f0_vector, const std::vector<float>& volume_vector)
+{
+    std::vector<float> output_data(f0_vector.size() * samplesPerFrame);
+
+    if (!invoke_sf_decode_forward(speaker_id, f0_vector.size(), phoneme_vector.data(), f0_vector.data(), volume_vector.data(), output_data.data()))
+    {
+        return std::nullopt;
+    }
+
+    return output_data;
+}
+
+std::optional<VoicevoxFrameSpan<float>> VoicevoxCoreHost::sf_decode_forward(VoicevoxFrameArena& arena, juce::uint32 speaker_id, VoicevoxFrameSpan<const std::int64_t> phoneme_vector, VoicevoxFrameSpan<const float> f0_vector, VoicevoxFrameSpan<const float> volume_vector)
+{
+    auto output_data = arena.allocate<float>(f0_vector.size() * samplesPerFrame);
+
+    if (!invoke_sf_decode_forward(speaker_id, f0_vector.size(), phoneme_vector.data(), f0_vector.data(), volume_vector.data(), output_data.data()))
+    {
+        return std::nullopt;
+    }
+
+    return output_data;
+}
+
+bool VoicevoxCoreHost::invoke_sf_decode_forward(juce::uint32 speaker_id, size_t length, const std::int64_t* phoneme, const float* f0, const float* volume, float* output)
 {
     jassert(sharedVoicevoxCoreLibrary->isHandled());
 
     int64_t speaker_id_i64 = speaker_id;
 
-    uintptr_t output_data_length = f0_vector.size() * 256;
-
-    juce::HeapBlock<float> output_data;
-    output_data.malloc(output_data_length);
+    VoicevoxScopedEventTimer event_timer(VoicevoxEventId::SfDecode, speaker_id);
 
     const auto function_sf_decode_forward = (voicevox_sf_decode_forward)sharedVoicevoxCoreLibrary->getDynamicLibrary()->getFunction("sf_decode_forward");
     if (function_sf_decode_forward == nullptr)
     {
-        juce::Logger::outputDebugString(juce::CharPointer_UTF8("[voicevox_juce] sf_decode_forward function is not found."));
-        return std::nullopt;
+        event_timer.setResultCode(VoicevoxEventLog::resultFunctionNotFound);
+        return false;
     }
 
     // NOTE: sf_decode_forward function is processed under 24kHz due to hard coded in core library.
-    const auto is_success = function_sf_decode_forward(f0_vector.size(), phoneme_vector.data(), f0_vector.data(), volume_vector.data(), &speaker_id_i64, output_data.getData());
+    const auto is_success = function_sf_decode_forward((int64_t)length, const_cast<int64_t*>(phoneme), const_cast<float*>(f0), const_cast<float*>(volume), &speaker_id_i64, output);
     if (!is_success)
     {
-        juce::Logger::outputDebugString(juce::CharPointer_UTF8("[voicevox_juce] sf_decode_forward function is failure."));
-        return std::nullopt;
+        event_timer.setResultCode(VoicevoxEventLog::resultFunctionFailure);
+        return false;
     }
 
-    return std::vector<float>(output_data.getData(), output_data.getData() + output_data_length);
+    return true;
 }
 
 #if 0
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <juce_core/juce_core.h>
+#include "../voicevox_memory/voicevox_frame_arena.h"
+#include "../voicevox_threading/voicevox_thread_placement.h"
 
 namespace voicevox
 {
@@ -38,12 +40,29 @@ public:
 
     //==============================================================================
     // Song API
-    std::optional<std::vector<std::int64_t>> predict_sing_consonant_length_forward(juce::uint32 speaker_id, std::vector<std::int64_t> consonant, std::vector<std::int64_t> vowel, std::vector<std::int64_t> note_duration);
-    std::optional<std::vector<float>> predict_sing_f0_forward(juce::uint32 speaker_idd, std::vector<std::int64_t> phoneme, std::vector<std::int64_t> note);
-    std::optional<std::vector<float>> predict_sing_volume_forward(juce::uint32 speaker_id, std::vector<std::int64_t> phoneme, std::vector<std::int64_t> note, std::vector<float> f0);
-    std::optional<std::vector<float>> sf_decode_forward(juce::uint32 speaker_id, std::vector<std::int64_t> phoneme_vector, std::vector<float> f0_vector, std::vector<float> volume_vector);
+    std::optional<std::vector<std::int64_t>> predict_sing_consonant_length_forward(juce::uint32 speaker_id, const std::vector<std::int64_t>& consonant, const std::vector<std::int64_t>& vowel, const std::vector<std::int64_t>& note_duration);
+    std::optional<std::vector<float>> predict_sing_f0_forward(juce::uint32 speaker_id, const std::vector<std::int64_t>& phoneme, const std::vector<std::int64_t>& note);
+    std::optional<std::vector<float>> predict_sing_volume_forward(juce::uint32 speaker_id, const std::vector<std::int64_t>& phoneme, const std::vector<std::int64_t>& note, const std::vector<float>& f0);
+    std::optional<std::vector<float>> sf_decode_forward(juce::uint32 speaker_id, const std::vector<std::int64_t>& phoneme_vector, const std::vector<float>& f0_vector, const std::vector<float>& volume_vector);
+
+    //==============================================================================
+    // Song API writing into arena, returned spans are valid until the arena is reset.
+    std::optional<VoicevoxFrameSpan<std::int64_t>> predict_sing_consonant_length_forward(VoicevoxFrameArena& arena, juce::uint32 speaker_id, VoicevoxFrameSpan<const std::int64_t> consonant, VoicevoxFrameSpan<const std::int64_t> vowel, VoicevoxFrameSpan<const std::int64_t> note_duration);
+    std::optional<VoicevoxFrameSpan<float>> predict_sing_f0_forward(VoicevoxFrameArena& arena, juce::uint32 speaker_id, VoicevoxFrameSpan<const std::int64_t> phoneme, VoicevoxFrameSpan<const std::int64_t> note);
+    std::optional<VoicevoxFrameSpan<float>> predict_sing_volume_forward(VoicevoxFrameArena& arena, juce::uint32 speaker_id, VoicevoxFrameSpan<const std::int64_t> phoneme, VoicevoxFrameSpan<const std::int64_t> note, VoicevoxFrameSpan<const float> f0);
+    std::optional<VoicevoxFrameSpan<float>> sf_decode_forward(VoicevoxFrameArena& arena, juce::uint32 speaker_id, VoicevoxFrameSpan<const std::int64_t> phoneme_vector, VoicevoxFrameSpan<const float> f0_vector, VoicevoxFrameSpan<const float> volume_vector);
+
+    //==============================================================================
+    // NOTE: sf_decode_forward outputs fixed number of samples per frame.
+    static constexpr size_t samplesPerFrame = 256;
 
 private:
+    //==============================================================================
+    bool invoke_predict_sing_consonant_length_forward(juce::uint32 speaker_id, size_t length, const std::int64_t* consonant, const std::int64_t* vowel, const std::int64_t* note_duration, std::int64_t* output);
+    bool invoke_predict_sing_f0_forward(juce::uint32 speaker_id, size_t length, const std::int64_t* phoneme, const std::int64_t* note, float* output);
+    bool invoke_predict_sing_volume_forward(juce::uint32 speaker_id, size_t length, const std::int64_t* phoneme, const std::int64_t* note, const float* f0, float* output);
+    bool invoke_sf_decode_forward(juce::uint32 speaker_id, size_t length, const std::int64_t* phoneme, const float* f0, const float* volume, float* output);
+
 #if 0
     //==============================================================================
     std::optional<juce::Array<float>> decode(juce::uint32 speaker_id, std::vector<float> f0_vector, std::vector<float> phoneme_vector);
@@ -0,0 +1,854 @@
+#include "voicevox_audio_kernels.h"
+
+#if JUCE_INTEL
+ #include <immintrin.h>
+#elif JUCE_ARM && (defined(__aarch64__) || defined(_M_ARM64))
+ #include <arm_neon.h>
+ #define VOICEVOX_AUDIO_KERNELS_NEON 1
+#endif
+
+// NOTE: SSE2 is only guaranteed on x86_64, 32 bit builds may target older CPUs,
+//       so SSE2 code is compiled for its own target as well and selected at runtime.
+#if JUCE_INTEL && (JUCE_GCC || JUCE_CLANG)
+ #define VOICEVOX_AUDIO_KERNELS_SSE2_TARGET __attribute__((target("sse2")))
+ #define VOICEVOX_AUDIO_KERNELS_AVX2_TARGET __attribute__((target("avx2")))
+#else
+ #define VOICEVOX_AUDIO_KERNELS_SSE2_TARGET
+ #define VOICEVOX_AUDIO_KERNELS_AVX2_TARGET
+#endif
+
+namespace voicevox
+{
+
+namespace
+{
+    constexpr float int16Scale = 32767.0f;
+    constexpr float int24Scale = 8388607.0f;
+
+    // NaN is written as silence by every conversion.
+    inline float clipSample(float sample)
+    {
+        return std::isnan(sample) ? 0.0f : std::min(1.0f, std::max(-1.0f, sample));
+    }
+
+    // Largest sample below 1.0 that still fits the integer range, input is scaled by 2^(bits - 1).
+    inline float getFixedPointMaxSample(int bits_per_sample)
+    {
+        const auto scale = (float)(1 << (bits_per_sample - 1));
+        return (scale - 1.0f) / scale;
+    }
+
+    inline void writeInt24(std::uint8_t* dest, std::int32_t value)
+    {
+        dest[0] = (std::uint8_t)(value & 0xff);
+        dest[1] = (std::uint8_t)((value >> 8) & 0xff);
+        dest[2] = (std::uint8_t)((value >> 16) & 0xff);
+    }
+
+    //==============================================================================
+    struct AudioKernelTable
+    {
+        VoicevoxAudioKernels::InstructionSet instructionSet;
+        void (*applyGain)(float*, size_t, float);
+        float (*findPeak)(const float*, size_t);
+        void (*crossfade)(float*, const float*, size_t);
+        void (*convertToInt16)(const float*, std::int16_t*, size_t);
+        void (*convertToInt24)(const float*, std::uint8_t*, size_t);
+        void (*convertToInt32)(const float*, std::int32_t*, size_t, int);
+        void (*interleaveStereo)(const float*, const float*, float*, size_t);
+    };
+
+    void interleaveStereoScalar(const float* left, const float* right, float* dest, size_t num_samples)
+    {
+        for (size_t index = 0; index < num_samples; index++)
+        {
+            dest[index * 2] = left[index];
+            dest[index * 2 + 1] = right[index];
+        }
+    }
+
+#if JUCE_INTEL
+    //==============================================================================
+    // SSE2
+    // Clips to [-1, max_sample] and replaces NaN with 0, same as clipSample().
+    VOICEVOX_AUDIO_KERNELS_SSE2_TARGET inline __m128 clipSSE2(__m128 samples, __m128 max_vector)
+    {
+        const auto ordered = _mm_and_ps(samples, _mm_cmpord_ps(samples, samples));
+        return _mm_min_ps(_mm_max_ps(ordered, _mm_set1_ps(-1.0f)), max_vector);
+    }
+
+    VOICEVOX_AUDIO_KERNELS_SSE2_TARGET void applyGainSSE2(float* samples, size_t num_samples, float gain)
+    {
+        const auto gain_vector = _mm_set1_ps(gain);
+
+        size_t index = 0;
+        for (; index + 4 <= num_samples; index += 4)
+        {
+            _mm_storeu_ps(samples + index, _mm_mul_ps(_mm_loadu_ps(samples + index), gain_vector));
+        }
+
+        VoicevoxAudioKernels::Scalar::applyGain(samples + index, num_samples - index, gain);
+    }
+
+    VOICEVOX_AUDIO_KERNELS_SSE2_TARGET float findPeakSSE2(const float* samples, size_t num_samples)
+    {
+        const auto sign_mask = _mm_set1_ps(-0.0f);
+        auto peak_vector = _mm_setzero_ps();
+
+        // NOTE: max_ps returns the second operand when either is NaN, so NaN samples keep the peak as Scalar::findPeak does.
+        size_t index = 0;
+        for (; index + 4 <= num_samples; index += 4)
+        {
+            peak_vector = _mm_max_ps(_mm_andnot_ps(sign_mask, _mm_loadu_ps(samples + index)), peak_vector);
+        }
+
+        peak_vector = _mm_max_ps(peak_vector, _mm_shuffle_ps(peak_vector, peak_vector, _MM_SHUFFLE(1, 0, 3, 2)));
+        peak_vector = _mm_max_ps(peak_vector, _mm_shuffle_ps(peak_vector, peak_vector, _MM_SHUFFLE(2, 3, 0, 1)));
+
+        return std::max(_mm_cvtss_f32(peak_vector), VoicevoxAudioKernels::Scalar::findPeak(samples + index, num_samples - index));
+    }
+
+    VOICEVOX_AUDIO_KERNELS_SSE2_TARGET void crossfadeSSE2(float* dest, const float* source, size_t num_samples)
+    {
+        if (num_samples == 0)
+        {
+            return;
+        }
+
+        const auto step = 1.0f / (float)num_samples;
+        const auto step_vector = _mm_set1_ps(step);
+        const auto increment = _mm_set1_ps(4.0f);
+        auto position = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+
+        size_t index = 0;
+        for (; index + 4 <= num_samples; index += 4)
+        {
+            const auto fade_in = _mm_mul_ps(position, step_vector);
+            const auto dest_vector = _mm_loadu_ps(dest + index);
+            const auto source_vector = _mm_loadu_ps(source + index);
+
+            _mm_storeu_ps(dest + index, _mm_add_ps(dest_vector, _mm_mul_ps(_mm_sub_ps(source_vector, dest_vector), fade_in)));
+            position = _mm_add_ps(position, increment);
+        }
+
+        for (; index < num_samples; index++)
+        {
+            const auto fade_in = (float)index * step;
+            dest[index] = dest[index] + (source[index] - dest[index]) * fade_in;
+        }
+    }
+
+    VOICEVOX_AUDIO_KERNELS_SSE2_TARGET void convertToInt16SSE2(const float* source, std::int16_t* dest, size_t num_samples)
+    {
+        const auto max_vector = _mm_set1_ps(1.0f);
+        const auto scale_vector = _mm_set1_ps(int16Scale);
+
+        size_t index = 0;
+        for (; index + 8 <= num_samples; index += 8)
+        {
+            const auto low = _mm_cvtps_epi32(_mm_mul_ps(clipSSE2(_mm_loadu_ps(source + index), max_vector), scale_vector));
+            const auto high = _mm_cvtps_epi32(_mm_mul_ps(clipSSE2(_mm_loadu_ps(source + index + 4), max_vector), scale_vector));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + index), _mm_packs_epi32(low, high));
+        }
+
+        VoicevoxAudioKernels::Scalar::convertToInt16(source + index, dest + index, num_samples - index);
+    }
+
+    VOICEVOX_AUDIO_KERNELS_SSE2_TARGET void convertToInt24SSE2(const float* source, std::uint8_t* dest, size_t num_samples)
+    {
+        const auto max_vector = _mm_set1_ps(1.0f);
+        const auto scale_vector = _mm_set1_ps(int24Scale);
+
+        alignas(16) std::int32_t converted[4];
+
+        size_t index = 0;
+        for (; index + 4 <= num_samples; index += 4)
+        {
+            const auto clipped = clipSSE2(_mm_loadu_ps(source + index), max_vector);
+            _mm_store_si128(reinterpret_cast<__m128i*>(converted), _mm_cvtps_epi32(_mm_mul_ps(clipped, scale_vector)));
+
+            for (size_t lane = 0; lane < 4; lane++)
+            {
+                writeInt24(dest + (index + lane) * 3, converted[lane]);
+            }
+        }
+
+        VoicevoxAudioKernels::Scalar::convertToInt24(source + index, dest + index * 3, num_samples - index);
+    }
+
+    VOICEVOX_AUDIO_KERNELS_SSE2_TARGET void convertToInt32SSE2(const float* source, std::int32_t* dest, size_t num_samples, int bits_per_sample)
+    {
+        const auto max_vector = _mm_set1_ps(getFixedPointMaxSample(bits_per_sample));
+        const auto scale_vector = _mm_set1_ps((float)(1 << (bits_per_sample - 1)));
+        const auto shift = _mm_cvtsi32_si128(32 - bits_per_sample);
+
+        size_t index = 0;
+        for (; index + 4 <= num_samples; index += 4)
+        {
+            const auto converted = _mm_cvtps_epi32(_mm_mul_ps(clipSSE2(_mm_loadu_ps(source + index), max_vector), scale_vector));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + index), _mm_sll_epi32(converted, shift));
+        }
+
+        VoicevoxAudioKernels::Scalar::convertToInt32(source + index, dest + index, num_samples - index, bits_per_sample);
+    }
+
+    VOICEVOX_AUDIO_KERNELS_SSE2_TARGET void interleaveStereoSSE2(const float* left, const float* right, float* dest, size_t num_samples)
+    {
+        size_t index = 0;
+        for (; index + 4 <= num_samples; index += 4)
+        {
+            const auto left_vector = _mm_loadu_ps(left + index);
+            const auto right_vector = _mm_loadu_ps(right + index);
+
+            _mm_storeu_ps(dest + index * 2, _mm_unpacklo_ps(left_vector, right_vector));
+            _mm_storeu_ps(dest + index * 2 + 4, _mm_unpackhi_ps(left_vector, right_vector));
+        }
+
+        interleaveStereoScalar(left + index, right + index, dest + index * 2, num_samples - index);
+    }
+
+    //==============================================================================
+    // AVX2
+    VOICEVOX_AUDIO_KERNELS_AVX2_TARGET inline __m256 clipAVX2(__m256 samples, __m256 max_vector)
+    {
+        const auto ordered = _mm256_and_ps(samples, _mm256_cmp_ps(samples, samples, _CMP_ORD_Q));
+        return _mm256_min_ps(_mm256_max_ps(ordered, _mm256_set1_ps(-1.0f)), max_vector);
+    }
+
+    VOICEVOX_AUDIO_KERNELS_AVX2_TARGET void applyGainAVX2(float* samples, size_t num_samples, float gain)
+    {
+        const auto gain_vector = _mm256_set1_ps(gain);
+
+        size_t index = 0;
+        for (; index + 8 <= num_samples; index += 8)
+        {
+            _mm256_storeu_ps(samples + index, _mm256_mul_ps(_mm256_loadu_ps(samples + index), gain_vector));
+        }
+
+        applyGainSSE2(samples + index, num_samples - index, gain);
+    }
+
+    VOICEVOX_AUDIO_KERNELS_AVX2_TARGET float findPeakAVX2(const float* samples, size_t num_samples)
+    {
+        const auto sign_mask = _mm256_set1_ps(-0.0f);
+        auto peak_vector = _mm256_setzero_ps();
+
+        size_t index = 0;
+        for (; index + 8 <= num_samples; index += 8)
+        {
+            peak_vector = _mm256_max_ps(_mm256_andnot_ps(sign_mask, _mm256_loadu_ps(samples + index)), peak_vector);
+        }
+
+        auto half_peak_vector = _mm_max_ps(_mm256_castps256_ps128(peak_vector), _mm256_extractf128_ps(peak_vector, 1));
+        half_peak_vector = _mm_max_ps(half_peak_vector, _mm_shuffle_ps(half_peak_vector, half_peak_vector, _MM_SHUFFLE(1, 0, 3, 2)));
+        half_peak_vector = _mm_max_ps(half_peak_vector, _mm_shuffle_ps(half_peak_vector, half_peak_vector, _MM_SHUFFLE(2, 3, 0, 1)));
+
+        return std::max(_mm_cvtss_f32(half_peak_vector), findPeakSSE2(samples + index, num_samples - index));
+    }
+
+    VOICEVOX_AUDIO_KERNELS_AVX2_TARGET void crossfadeAVX2(float* dest, const float* source, size_t num_samples)
+    {
+        if (num_samples == 0)
+        {
+            return;
+        }
+
+        const auto step = 1.0f / (float)num_samples;
+        const auto step_vector = _mm256_set1_ps(step);
+        const auto increment = _mm256_set1_ps(8.0f);
+        auto position = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+
+        size_t index = 0;
+        for (; index + 8 <= num_samples; index += 8)
+        {
+            const auto fade_in = _mm256_mul_ps(position, step_vector);
+            const auto dest_vector = _mm256_loadu_ps(dest + index);
+            const auto source_vector = _mm256_loadu_ps(source + index);
+
+            _mm256_storeu_ps(dest + index, _mm256_add_ps(dest_vector, _mm256_mul_ps(_mm256_sub_ps(source_vector, dest_vector), fade_in)));
+            position = _mm256_add_ps(position, increment);
+        }
+
+        for (; index < num_samples; index++)
+        {
+            const auto fade_in = (float)index * step;
+            dest[index] = dest[index] + (source[index] - dest[index]) * fade_in;
+        }
+    }
+
+    VOICEVOX_AUDIO_KERNELS_AVX2_TARGET void convertToInt16AVX2(const float* source, std::int16_t* dest, size_t num_samples)
+    {
+        const auto max_vector = _mm256_set1_ps(1.0f);
+        const auto scale_vector = _mm256_set1_ps(int16Scale);
+
+        size_t index = 0;
+        for (; index + 16 <= num_samples; index += 16)
+        {
+            const auto clipped_low = clipAVX2(_mm256_loadu_ps(source + index), max_vector);
+            const auto clipped_high = clipAVX2(_mm256_loadu_ps(source + index + 8), max_vector);
+
+            const auto packed = _mm256_packs_epi32(_mm256_cvtps_epi32(_mm256_mul_ps(clipped_low, scale_vector)),
+                                                   _mm256_cvtps_epi32(_mm256_mul_ps(clipped_high, scale_vector)));
+
+            // NOTE: packs works per 128bit lane, restore sample order across lanes.
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + index), _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0)));
+        }
+
+        convertToInt16SSE2(source + index, dest + index, num_samples - index);
+    }
+
+    VOICEVOX_AUDIO_KERNELS_AVX2_TARGET void convertToInt24AVX2(const float* source, std::uint8_t* dest, size_t num_samples)
+    {
+        const auto max_vector = _mm256_set1_ps(1.0f);
+        const auto scale_vector = _mm256_set1_ps(int24Scale);
+
+        // NOTE: Gather the low 3 bytes of each 32bit sample into the low 12 bytes of each lane.
+        const auto shuffle_mask = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+                                                   0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+
+        alignas(32) std::uint8_t packed_bytes[32];
+
+        size_t index = 0;
+        for (; index + 8 <= num_samples; index += 8)
+        {
+            const auto clipped = clipAVX2(_mm256_loadu_ps(source + index), max_vector);
+            const auto converted = _mm256_cvtps_epi32(_mm256_mul_ps(clipped, scale_vector));
+
+            _mm256_store_si256(reinterpret_cast<__m256i*>(packed_bytes), _mm256_shuffle_epi8(converted, shuffle_mask));
+
+            std::memcpy(dest + index * 3, packed_bytes, 12);
+            std::memcpy(dest + index * 3 + 12, packed_bytes + 16, 12);
+        }
+
+        convertToInt24SSE2(source + index, dest + index * 3, num_samples - index);
+    }
+
+    VOICEVOX_AUDIO_KERNELS_AVX2_TARGET void convertToInt32AVX2(const float* source, std::int32_t* dest, size_t num_samples, int bits_per_sample)
+    {
+        const auto max_vector = _mm256_set1_ps(getFixedPointMaxSample(bits_per_sample));
+        const auto scale_vector = _mm256_set1_ps((float)(1 << (bits_per_sample - 1)));
+        const auto shift = _mm_cvtsi32_si128(32 - bits_per_sample);
+
+        size_t index = 0;
+        for (; index + 8 <= num_samples; index += 8)
+        {
+            const auto converted = _mm256_cvtps_epi32(_mm256_mul_ps(clipAVX2(_mm256_loadu_ps(source + index), max_vector), scale_vector));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + index), _mm256_sll_epi32(converted, shift));
+        }
+
+        convertToInt32SSE2(source + index, dest + index, num_samples - index, bits_per_sample);
+    }
+
+    VOICEVOX_AUDIO_KERNELS_AVX2_TARGET void interleaveStereoAVX2(const float* left, const float* right, float* dest, size_t num_samples)
+    {
+        size_t index = 0;
+        for (; index + 8 <= num_samples; index += 8)
+        {
+            const auto left_vector = _mm256_loadu_ps(left + index);
+            const auto right_vector = _mm256_loadu_ps(right + index);
+
+            const auto low = _mm256_unpacklo_ps(left_vector, right_vector);
+            const auto high = _mm256_unpackhi_ps(left_vector, right_vector);
+
+            _mm256_storeu_ps(dest + index * 2, _mm256_permute2f128_ps(low, high, 0x20));
+            _mm256_storeu_ps(dest + index * 2 + 8, _mm256_permute2f128_ps(low, high, 0x31));
+        }
+
+        interleaveStereoSSE2(left + index, right + index, dest + index * 2, num_samples - index);
+    }
+#endif
+
+#if VOICEVOX_AUDIO_KERNELS_NEON
+    //==============================================================================
+    // NEON
+    inline float32x4_t clipNEON(float32x4_t samples, float32x4_t max_vector)
+    {
+        const auto ordered = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(samples), vceqq_f32(samples, samples)));
+        return vminq_f32(vmaxq_f32(ordered, vdupq_n_f32(-1.0f)), max_vector);
+    }
+
+    void applyGainNEON(float* samples, size_t num_samples, float gain)
+    {
+        const auto gain_vector = vdupq_n_f32(gain);
+
+        size_t index = 0;
+        for (; index + 4 <= num_samples; index += 4)
+        {
+            vst1q_f32(samples + index, vmulq_f32(vld1q_f32(samples + index), gain_vector));
+        }
+
+        VoicevoxAudioKernels::Scalar::applyGain(samples + index, num_samples - index, gain);
+    }
+
+    float findPeakNEON(const float* samples, size_t num_samples)
+    {
+        auto peak_vector = vdupq_n_f32(0.0f);
+
+        size_t index = 0;
+        for (; index + 4 <= num_samples; index += 4)
+        {
+            // NOTE: maxnm ignores NaN like Scalar::findPeak, max would propagate it.
+            peak_vector = vmaxnmq_f32(peak_vector, vabsq_f32(vld1q_f32(samples + index)));
+        }
+
+        return std::max(vmaxvq_f32(peak_vector), VoicevoxAudioKernels::Scalar::findPeak(samples + index, num_samples - index));
+    }
+
+    void crossfadeNEON(float* dest, const float* source, size_t num_samples)
+    {
+        if (num_samples == 0)
+        {
+            return;
+        }
+
+        const auto step = 1.0f / (float)num_samples;
+        const auto step_vector = vdupq_n_f32(step);
+        const auto increment = vdupq_n_f32(4.0f);
+        const float initial_position[] = { 0.0f, 1.0f, 2.0f, 3.0f };
+        auto position = vld1q_f32(initial_position);
+
+        size_t index = 0;
+        for (; index + 4 <= num_samples; index += 4)
+        {
+            const auto fade_in = vmulq_f32(position, step_vector);
+            const auto dest_vector = vld1q_f32(dest + index);
+            const auto source_vector = vld1q_f32(source + index);
+
+            vst1q_f32(dest + index, vaddq_f32(dest_vector, vmulq_f32(vsubq_f32(source_vector, dest_vector), fade_in)));
+            position = vaddq_f32(position, increment);
+        }
+
+        for (; index < num_samples; index++)
+        {
+            const auto fade_in = (float)index * step;
+            dest[index] = dest[index] + (source[index] - dest[index]) * fade_in;
+        }
+    }
+
+    void convertToInt16NEON(const float* source, std::int16_t* dest, size_t num_samples)
+    {
+        const auto max_vector = vdupq_n_f32(1.0f);
+        const auto scale_vector = vdupq_n_f32(int16Scale);
+
+        const auto convert = [&](const float* block) {
+            return vqmovn_s32(vcvtnq_s32_f32(vmulq_f32(clipNEON(vld1q_f32(block), max_vector), scale_vector)));
+        };
+
+        size_t index = 0;
+        for (; index + 8 <= num_samples; index += 8)
+        {
+            vst1q_s16(dest + index, vcombine_s16(convert(source + index), convert(source + index + 4)));
+        }
+
+        VoicevoxAudioKernels::Scalar::convertToInt16(source + index, dest + index, num_samples - index);
+    }
+
+    void convertToInt24NEON(const float* source, std::uint8_t* dest, size_t num_samples)
+    {
+        const auto max_vector = vdupq_n_f32(1.0f);
+        const auto scale_vector = vdupq_n_f32(int24Scale);
+
+        std::int32_t converted[4];
+
+        size_t index = 0;
+        for (; index + 4 <= num_samples; index += 4)
+        {
+            const auto clipped = clipNEON(vld1q_f32(source + index), max_vector);
+            vst1q_s32(converted, vcvtnq_s32_f32(vmulq_f32(clipped, scale_vector)));
+
+            for (size_t lane = 0; lane < 4; lane++)
+            {
+                writeInt24(dest + (index + lane) * 3, converted[lane]);
+            }
+        }
+
+        VoicevoxAudioKernels::Scalar::convertToInt24(source + index, dest + index * 3, num_samples - index);
+    }
+
+    void convertToInt32NEON(const float* source, std::int32_t* dest, size_t num_samples, int bits_per_sample)
+    {
+        const auto max_vector = vdupq_n_f32(getFixedPointMaxSample(bits_per_sample));
+        const auto scale_vector = vdupq_n_f32((float)(1 << (bits_per_sample - 1)));
+        const auto shift = vdupq_n_s32(32 - bits_per_sample);
+
+        size_t index = 0;
+        for (; index + 4 <= num_samples; index += 4)
+        {
+            const auto converted = vcvtnq_s32_f32(vmulq_f32(clipNEON(vld1q_f32(source + index), max_vector), scale_vector));
+            vst1q_s32(dest + index, vshlq_s32(converted, shift));
+        }
+
+        VoicevoxAudioKernels::Scalar::convertToInt32(source + index, dest + index, num_samples - index, bits_per_sample);
+    }
+
+    void interleaveStereoNEON(const float* left, const float* right, float* dest, size_t num_samples)
+    {
+        size_t index = 0;
+        for (; index + 4 <= num_samples; index += 4)
+        {
+            float32x4x2_t stereo;
+            stereo.val[0] = vld1q_f32(left + index);
+            stereo.val[1] = vld1q_f32(right + index);
+
+            vst2q_f32(dest + index * 2, stereo);
+        }
+
+        interleaveStereoScalar(left + index, right + index, dest + index * 2, num_samples - index);
+    }
+#endif
+
+    //==============================================================================
+    AudioKernelTable createAudioKernelTable()
+    {
+        const AudioKernelTable scalar_table = { VoicevoxAudioKernels::InstructionSet::Scalar,
+                                                VoicevoxAudioKernels::Scalar::applyGain,
+                                                VoicevoxAudioKernels::Scalar::findPeak,
+                                                VoicevoxAudioKernels::Scalar::crossfade,
+                                                VoicevoxAudioKernels::Scalar::convertToInt16,
+                                                VoicevoxAudioKernels::Scalar::convertToInt24,
+                                                VoicevoxAudioKernels::Scalar::convertToInt32,
+                                                interleaveStereoScalar };
+
+#if JUCE_INTEL
+        if (juce::SystemStats::hasAVX2())
+        {
+            return { VoicevoxAudioKernels::InstructionSet::AVX2, applyGainAVX2, findPeakAVX2, crossfadeAVX2, convertToInt16AVX2, convertToInt24AVX2, convertToInt32AVX2, interleaveStereoAVX2 };
+        }
+
+        // NOTE: Always true on x86_64, 32 bit x86 builds may still run on CPUs without SSE2.
+        if (juce::SystemStats::hasSSE2())
+        {
+            return { VoicevoxAudioKernels::InstructionSet::SSE2, applyGainSSE2, findPeakSSE2, crossfadeSSE2, convertToInt16SSE2, convertToInt24SSE2, convertToInt32SSE2, interleaveStereoSSE2 };
+        }
+
+        return scalar_table;
+#elif VOICEVOX_AUDIO_KERNELS_NEON
+        juce::ignoreUnused(scalar_table);
+        return { VoicevoxAudioKernels::InstructionSet::NEON, applyGainNEON, findPeakNEON, crossfadeNEON, convertToInt16NEON, convertToInt24NEON, convertToInt32NEON, interleaveStereoNEON };
+#else
+        return scalar_table;
+#endif
+    }
+
+    const AudioKernelTable& getAudioKernelTable()
+    {
+        static const AudioKernelTable table = createAudioKernelTable();
+        return table;
+    }
+
+    //==============================================================================
+    // Speech like range with clipped peaks, exact full scale and non finite samples sprinkled in.
+    std::vector<float> makeAudioKernelTestSignal(size_t num_samples, juce::int64 seed)
+    {
+        juce::Random random(seed);
+        std::vector<float> signal(num_samples);
+
+        for (size_t index = 0; index < num_samples; index++)
+        {
+            signal[index] = (random.nextFloat() * 2.0f - 1.0f) * 1.25f;
+        }
+
+        const float special_samples[] = { std::numeric_limits<float>::quiet_NaN(), std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(), 1.0f, -1.0f, 0.0f };
+        for (size_t index = 0; index < num_samples; index += 997)
+        {
+            signal[index] = special_samples[(index / 997) % juce::numElementsInArray(special_samples)];
+        }
+
+        return signal;
+    }
+
+    double getAudioKernelDifference(float lhs, float rhs)
+    {
+        if (std::isnan(lhs) || std::isnan(rhs))
+        {
+            return std::isnan(lhs) && std::isnan(rhs) ? 0.0 : std::numeric_limits<double>::infinity();
+        }
+
+        return lhs == rhs ? 0.0 : std::abs((double)lhs - (double)rhs);
+    }
+
+    std::int32_t readInt24(const std::uint8_t* source)
+    {
+        const auto value = (std::int32_t)((std::uint32_t)source[0] | ((std::uint32_t)source[1] << 8) | ((std::uint32_t)source[2] << 16));
+        return (value & 0x800000) != 0 ? value - 0x1000000 : value;
+    }
+
+    template <typename Prepare, typename Run>
+    double measureAudioKernelSeconds(int num_runs, Prepare&& prepare, Run&& run)
+    {
+        juce::int64 ticks = 0;
+
+        for (int run_index = 0; run_index < num_runs; run_index++)
+        {
+            prepare();
+
+            const auto start_ticks = juce::Time::getHighResolutionTicks();
+            run();
+            ticks += juce::Time::getHighResolutionTicks() - start_ticks;
+        }
+
+        return juce::Time::highResolutionTicksToSeconds(ticks);
+    }
+}
+
+//==============================================================================
+VoicevoxAudioKernels::InstructionSet VoicevoxAudioKernels::getInstructionSet()
+{
+    return getAudioKernelTable().instructionSet;
+}
+
+juce::String VoicevoxAudioKernels::getInstructionSetName()
+{
+    switch (getInstructionSet())
+    {
+    case InstructionSet::SSE2:  return "SSE2";
+    case InstructionSet::AVX2:  return "AVX2";
+    case InstructionSet::NEON:  return "NEON";
+    case InstructionSet::Scalar:
+    default:                    return "Scalar";
+    }
+}
+
+//==============================================================================
+void VoicevoxAudioKernels::applyGain(float* samples, size_t num_samples, float gain)
+{
+    getAudioKernelTable().applyGain(samples, num_samples, gain);
+}
+
+float VoicevoxAudioKernels::findPeak(const float* samples, size_t num_samples)
+{
+    return getAudioKernelTable().findPeak(samples, num_samples);
+}
+
+float VoicevoxAudioKernels::normalisePeak(float* samples, size_t num_samples, float target_peak)
+{
+    const auto peak = findPeak(samples, num_samples);
+    if (peak <= 0.0f)
+    {
+        return 1.0f;
+    }
+
+    const auto gain = target_peak / peak;
+    applyGain(samples, num_samples, gain);
+
+    return gain;
+}
+
+void VoicevoxAudioKernels::crossfade(float* dest, const float* source, size_t num_samples)
+{
+    getAudioKernelTable().crossfade(dest, source, num_samples);
+}
+
+void VoicevoxAudioKernels::convertToInt16(const float* source, std::int16_t* dest, size_t num_samples)
+{
+    getAudioKernelTable().convertToInt16(source, dest, num_samples);
+}
+
+void VoicevoxAudioKernels::convertToInt24(const float* source, std::uint8_t* dest, size_t num_samples)
+{
+    getAudioKernelTable().convertToInt24(source, dest, num_samples);
+}
+
+void VoicevoxAudioKernels::convertToInt32(const float* source, std::int32_t* dest, size_t num_samples, int bits_per_sample)
+{
+    jassert(bits_per_sample >= 8 && bits_per_sample <= 24);
+    getAudioKernelTable().convertToInt32(source, dest, num_samples, bits_per_sample);
+}
+
+void VoicevoxAudioKernels::interleave(const float* const* source_channels, int num_channels, float* dest, size_t num_samples)
+{
+    if (num_channels == 2)
+    {
+        getAudioKernelTable().interleaveStereo(source_channels[0], source_channels[1], dest, num_samples);
+        return;
+    }
+
+    Scalar::interleave(source_channels, num_channels, dest, num_samples);
+}
+
+//==============================================================================
+void VoicevoxAudioKernels::Scalar::applyGain(float* samples, size_t num_samples, float gain)
+{
+    for (size_t index = 0; index < num_samples; index++)
+    {
+        samples[index] *= gain;
+    }
+}
+
+float VoicevoxAudioKernels::Scalar::findPeak(const float* samples, size_t num_samples)
+{
+    float peak = 0.0f;
+
+    for (size_t index = 0; index < num_samples; index++)
+    {
+        peak = std::max(peak, std::abs(samples[index]));
+    }
+
+    return peak;
+}
+
+void VoicevoxAudioKernels::Scalar::crossfade(float* dest, const float* source, size_t num_samples)
+{
+    if (num_samples == 0)
+    {
+        return;
+    }
+
+    const auto step = 1.0f / (float)num_samples;
+
+    for (size_t index = 0; index < num_samples; index++)
+    {
+        const auto fade_in = (float)index * step;
+        dest[index] = dest[index] + (source[index] - dest[index]) * fade_in;
+    }
+}
+
+void VoicevoxAudioKernels::Scalar::convertToInt16(const float* source, std::int16_t* dest, size_t num_samples)
+{
+    for (size_t index = 0; index < num_samples; index++)
+    {
+        dest[index] = (std::int16_t)std::lrint(clipSample(source[index]) * int16Scale);
+    }
+}
+
+void VoicevoxAudioKernels::Scalar::convertToInt24(const float* source, std::uint8_t* dest, size_t num_samples)
+{
+    for (size_t index = 0; index < num_samples; index++)
+    {
+        writeInt24(dest + index * 3, (std::int32_t)std::lrint(clipSample(source[index]) * int24Scale));
+    }
+}
+
+void VoicevoxAudioKernels::Scalar::convertToInt32(const float* source, std::int32_t* dest, size_t num_samples, int bits_per_sample)
+{
+    const auto max_sample = getFixedPointMaxSample(bits_per_sample);
+    const auto scale = (float)(1 << (bits_per_sample - 1));
+    const auto shift = 32 - bits_per_sample;
+
+    for (size_t index = 0; index < num_samples; index++)
+    {
+        const auto value = (std::int32_t)std::lrint(std::min(max_sample, clipSample(source[index])) * scale);
+        dest[index] = (std::int32_t)((std::uint32_t)value << shift);
+    }
+}
+
+void VoicevoxAudioKernels::Scalar::interleave(const float* const* source_channels, int num_channels, float* dest, size_t num_samples)
+{
+    for (int channel = 0; channel < num_channels; channel++)
+    {
+        const auto* source = source_channels[channel];
+
+        for (size_t index = 0; index < num_samples; index++)
+        {
+            dest[index * (size_t)num_channels + (size_t)channel] = source[index];
+        }
+    }
+}
+
+//==============================================================================
+std::vector<VoicevoxAudioKernelCheck> VoicevoxAudioKernels::verifyAgainstScalar(size_t num_samples, int num_runs)
+{
+    // NOTE: Odd length, so that the scalar tails of the vectorized kernels are checked as well.
+    num_samples |= 1;
+    num_runs = std::max(1, num_runs);
+
+    const auto source = makeAudioKernelTestSignal(num_samples, 0x766f6963);
+    const auto other_source = makeAudioKernelTestSignal(num_samples, 0x65766f78);
+
+    std::vector<VoicevoxAudioKernelCheck> checks;
+
+    const auto add_float_check = [&](const char* kernel_name, const std::vector<float>& scalar_output, const std::vector<float>& vectorized_output, double scalar_seconds, double vectorized_seconds) {
+        VoicevoxAudioKernelCheck check;
+        check.kernelName = kernel_name;
+        check.scalarSeconds = scalar_seconds;
+        check.vectorizedSeconds = vectorized_seconds;
+
+        for (size_t index = 0; index < scalar_output.size(); index++)
+        {
+            check.maxDifference = std::max(check.maxDifference, getAudioKernelDifference(scalar_output[index], vectorized_output[index]));
+        }
+
+        checks.push_back(check);
+    };
+
+    {
+        std::vector<float> scalar_output, vectorized_output;
+        const auto scalar_seconds = measureAudioKernelSeconds(num_runs, [&] { scalar_output = source; }, [&] { Scalar::applyGain(scalar_output.data(), num_samples, 0.7f); });
+        const auto vectorized_seconds = measureAudioKernelSeconds(num_runs, [&] { vectorized_output = source; }, [&] { applyGain(vectorized_output.data(), num_samples, 0.7f); });
+        add_float_check("applyGain", scalar_output, vectorized_output, scalar_seconds, vectorized_seconds);
+    }
+
+    {
+        float scalar_peak = 0.0f, vectorized_peak = 0.0f;
+        const auto scalar_seconds = measureAudioKernelSeconds(num_runs, [] {}, [&] { scalar_peak = Scalar::findPeak(source.data(), num_samples); });
+        const auto vectorized_seconds = measureAudioKernelSeconds(num_runs, [] {}, [&] { vectorized_peak = findPeak(source.data(), num_samples); });
+        add_float_check("findPeak", { scalar_peak }, { vectorized_peak }, scalar_seconds, vectorized_seconds);
+    }
+
+    {
+        std::vector<float> scalar_output, vectorized_output;
+        const auto scalar_seconds = measureAudioKernelSeconds(num_runs, [&] { scalar_output = source; }, [&] { Scalar::crossfade(scalar_output.data(), other_source.data(), num_samples); });
+        const auto vectorized_seconds = measureAudioKernelSeconds(num_runs, [&] { vectorized_output = source; }, [&] { crossfade(vectorized_output.data(), other_source.data(), num_samples); });
+        add_float_check("crossfade", scalar_output, vectorized_output, scalar_seconds, vectorized_seconds);
+    }
+
+    {
+        std::vector<std::int16_t> scalar_output(num_samples), vectorized_output(num_samples);
+        VoicevoxAudioKernelCheck check;
+        check.kernelName = "convertToInt16";
+        check.scalarSeconds = measureAudioKernelSeconds(num_runs, [] {}, [&] { Scalar::convertToInt16(source.data(), scalar_output.data(), num_samples); });
+        check.vectorizedSeconds = measureAudioKernelSeconds(num_runs, [] {}, [&] { convertToInt16(source.data(), vectorized_output.data(), num_samples); });
+
+        for (size_t index = 0; index < num_samples; index++)
+        {
+            check.maxDifference = std::max(check.maxDifference, (double)std::abs((int)scalar_output[index] - (int)vectorized_output[index]));
+        }
+
+        checks.push_back(check);
+    }
+
+    {
+        std::vector<std::uint8_t> scalar_output(num_samples * 3), vectorized_output(num_samples * 3);
+        VoicevoxAudioKernelCheck check;
+        check.kernelName = "convertToInt24";
+        check.scalarSeconds = measureAudioKernelSeconds(num_runs, [] {}, [&] { Scalar::convertToInt24(source.data(), scalar_output.data(), num_samples); });
+        check.vectorizedSeconds = measureAudioKernelSeconds(num_runs, [] {}, [&] { convertToInt24(source.data(), vectorized_output.data(), num_samples); });
+
+        for (size_t index = 0; index < num_samples; index++)
+        {
+            check.maxDifference = std::max(check.maxDifference, (double)std::abs(readInt24(scalar_output.data() + index * 3) - readInt24(vectorized_output.data() + index * 3)));
+        }
+
+        checks.push_back(check);
+    }
+
+    for (const auto bits_per_sample : { 16, 24 })
+    {
+        std::vector<std::int32_t> scalar_output(num_samples), vectorized_output(num_samples);
+        VoicevoxAudioKernelCheck check;
+        check.kernelName = "convertToInt32 (" + juce::String(bits_per_sample) + " bit)";
+        check.scalarSeconds = measureAudioKernelSeconds(num_runs, [] {}, [&] { Scalar::convertToInt32(source.data(), scalar_output.data(), num_samples, bits_per_sample); });
+        check.vectorizedSeconds = measureAudioKernelSeconds(num_runs, [] {}, [&] { convertToInt32(source.data(), vectorized_output.data(), num_samples, bits_per_sample); });
+
+        for (size_t index = 0; index < num_samples; index++)
+        {
+            const auto difference = ((juce::int64)scalar_output[index] - (juce::int64)vectorized_output[index]) / ((juce::int64)1 << (32 - bits_per_sample));
+            check.maxDifference = std::max(check.maxDifference, (double)std::abs(difference));
+        }
+
+        checks.push_back(check);
+    }
+
+    {
+        const float* const channels[] = { source.data(), other_source.data() };
+        std::vector<float> scalar_output(num_samples * 2), vectorized_output(num_samples * 2);
+        const auto scalar_seconds = measureAudioKernelSeconds(num_runs, [] {}, [&] { Scalar::interleave(channels, 2, scalar_output.data(), num_samples); });
+        const auto vectorized_seconds = measureAudioKernelSeconds(num_runs, [] {}, [&] { interleave(channels, 2, vectorized_output.data(), num_samples); });
+        add_float_check("interleave (stereo)", scalar_output, vectorized_output, scalar_seconds, vectorized_seconds);
+    }
+
+    return checks;
+}
+
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+namespace voicevox
+{
+
+//==============================================================================
+/** Result of comparing one kernel with its scalar reference. */
+struct VoicevoxAudioKernelCheck
+{
+    juce::String kernelName{};
+
+    // Largest difference to the scalar output, in samples for float outputs and in integer steps otherwise.
+    double maxDifference{ 0.0 };
+
+    double scalarSeconds{ 0.0 };
+    double vectorizedSeconds{ 0.0 };
+};
+
+//==============================================================================
+/**
+    Post-processing kernels for rendered audio.
+
+    Every kernel has a SSE2 / AVX2 / NEON implementation selected once at
+    runtime from the CPU features, and a scalar reference implementation in
+    VoicevoxAudioKernels::Scalar that is used when none of them is available.
+*/
+class VoicevoxAudioKernels final
+{
+public:
+    //==============================================================================
+    enum class InstructionSet
+    {
+        Scalar,
+        SSE2,
+        AVX2,
+        NEON
+    };
+
+    static InstructionSet getInstructionSet();
+    static juce::String getInstructionSetName();
+
+    //==============================================================================
+    // In place operations on rendered float buffers.
+    static void applyGain(float* samples, size_t num_samples, float gain);
+    static float findPeak(const float* samples, size_t num_samples);
+
+    // Returns applied gain, the buffer is left untouched if it is silent.
+    static float normalisePeak(float* samples, size_t num_samples, float target_peak = 1.0f);
+
+    // Linear crossfade from dest (fading out) to source (fading in), written into dest.
+    static void crossfade(float* dest, const float* source, size_t num_samples);
+
+    //==============================================================================
+    // Conversions, input samples are clipped to [-1.0, 1.0] and NaN is converted to silence.
+    static void convertToInt16(const float* source, std::int16_t* dest, size_t num_samples);
+
+    // Packed little endian 24bit, dest must hold num_samples * 3 bytes.
+    static void convertToInt24(const float* source, std::uint8_t* dest, size_t num_samples);
+
+    // Left justified bits_per_sample values as juce::AudioFormatWriter::write() takes them, 1.0 maps to 2^(bits - 1).
+    static void convertToInt32(const float* source, std::int32_t* dest, size_t num_samples, int bits_per_sample);
+
+    // dest must hold num_samples * num_channels samples.
+    static void interleave(const float* const* source_channels, int num_channels, float* dest, size_t num_samples);
+
+    //==============================================================================
+    struct Scalar
+    {
+        static void applyGain(float* samples, size_t num_samples, float gain);
+        static float findPeak(const float* samples, size_t num_samples);
+        static void crossfade(float* dest, const float* source, size_t num_samples);
+        static void convertToInt16(const float* source, std::int16_t* dest, size_t num_samples);
+        static void convertToInt24(const float* source, std::uint8_t* dest, size_t num_samples);
+        static void convertToInt32(const float* source, std::int32_t* dest, size_t num_samples, int bits_per_sample);
+        static void interleave(const float* const* source_channels, int num_channels, float* dest, size_t num_samples);
+    };
+
+    //==============================================================================
+    // Runs every kernel and its scalar reference on the same test signal, including out of range
+    // and non finite samples, and compares both outputs and run times.
+    static std::vector<VoicevoxAudioKernelCheck> verifyAgainstScalar(size_t num_samples = 240000, int num_runs = 20);
+
+private:
+    VoicevoxAudioKernels() = delete;
+};
+
+}
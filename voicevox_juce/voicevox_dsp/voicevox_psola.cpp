@@ -0,0 +1,131 @@
+#include "voicevox_psola.h"
+
+namespace voicevox
+{
+
+namespace
+{
+    struct PsolaPitchMark
+    {
+        int position;
+        int period;
+        bool isVoiced;
+    };
+}
+
+//==============================================================================
+std::vector<float> VoicevoxPsola::process(const float* input, size_t num_samples,
+                                          const float* f0, size_t num_frames,
+                                          const float* pitch_ratios,
+                                          double time_ratio,
+                                          const VoicevoxPsolaOptions& options)
+{
+    jassert(time_ratio > 0.0);
+    jassert(options.hopSize > 0);
+    jassert(options.minimumF0 > 0.0f);
+
+    const auto num_output_samples = (size_t)std::llround((double)num_samples * time_ratio);
+
+    if (num_samples == 0 || num_frames == 0 || num_output_samples == 0)
+    {
+        return std::vector<float>(num_output_samples, 0.0f);
+    }
+
+    const auto unvoiced_period = std::max(1, juce::roundToInt(options.sampleRate * options.unvoicedPeriodSeconds));
+
+    const auto get_frame_index = [&](double position) {
+        return (size_t)juce::jlimit(0.0, (double)(num_frames - 1), std::floor(position / options.hopSize));
+    };
+
+    //==============================================================================
+    // Analysis: place one mark per period following the f0 contour.
+    std::vector<PsolaPitchMark> pitch_marks;
+    pitch_marks.reserve(num_samples / (size_t)unvoiced_period + 1);
+
+    int position = 0;
+    while ((size_t)position < num_samples)
+    {
+        const auto frame_f0 = f0[get_frame_index(position)];
+        // NOTE: Also rejects NaN, and near zero f0 whose period would overflow roundToInt.
+        const auto is_voiced = frame_f0 >= options.minimumF0;
+        const auto period = is_voiced ? std::max(1, juce::roundToInt(options.sampleRate / frame_f0)) : unvoiced_period;
+
+        auto mark_position = position;
+
+        if (is_voiced)
+        {
+            // NOTE: Snap the mark to the largest peak around the predicted position to keep grains pitch synchronous.
+            const auto search_begin = pitch_marks.empty() ? position : std::max(position - period / 4, pitch_marks.back().position + period / 2);
+            const auto search_end = std::min((int)num_samples - 1, position + period / 4);
+
+            for (auto index = search_begin; index <= search_end; index++)
+            {
+                if (std::abs(input[index]) > std::abs(input[mark_position]))
+                {
+                    mark_position = index;
+                }
+            }
+        }
+
+        pitch_marks.push_back({ mark_position, period, is_voiced });
+        position = mark_position + period;
+    }
+
+    //==============================================================================
+    // Synthesis: overlap-add two period hann grains taken from the nearest analysis mark.
+    std::vector<float> output(num_output_samples, 0.0f);
+    std::vector<float> weights(num_output_samples, 0.0f);
+
+    size_t mark_index = 0;
+    double synthesis_position = 0.0;
+
+    while (synthesis_position < (double)num_output_samples)
+    {
+        const auto analysis_position = synthesis_position / time_ratio;
+
+        while (mark_index + 1 < pitch_marks.size()
+               && std::abs(pitch_marks[mark_index + 1].position - analysis_position) <= std::abs(pitch_marks[mark_index].position - analysis_position))
+        {
+            mark_index++;
+        }
+
+        const auto& mark = pitch_marks[mark_index];
+        const auto grain_center = (int)std::llround(synthesis_position);
+
+        for (auto offset = -mark.period; offset <= mark.period; offset++)
+        {
+            const auto source_index = mark.position + offset;
+            const auto dest_index = grain_center + offset;
+
+            if (source_index < 0 || (size_t)source_index >= num_samples || dest_index < 0 || (size_t)dest_index >= num_output_samples)
+            {
+                continue;
+            }
+
+            const auto window = 0.5f + 0.5f * std::cos(juce::MathConstants<float>::pi * (float)offset / (float)mark.period);
+
+            output[(size_t)dest_index] += input[source_index] * window;
+            weights[(size_t)dest_index] += window;
+        }
+
+        auto pitch_ratio = 1.0f;
+        if (mark.isVoiced && pitch_ratios != nullptr)
+        {
+            const auto frame_pitch_ratio = pitch_ratios[get_frame_index(mark.position)];
+            pitch_ratio = std::isfinite(frame_pitch_ratio) ? juce::jlimit(minPitchRatio, maxPitchRatio, frame_pitch_ratio) : 1.0f;
+        }
+
+        synthesis_position += (double)mark.period / (double)pitch_ratio;
+    }
+
+    // NOTE: Grains overlap more densely when pitch goes up, normalise by the window sum to keep the level.
+    //       Sparse regions and the edges are left as they are, boosting a small window sum produces clicks.
+    for (size_t index = 0; index < num_output_samples; index++)
+    {
+        output[index] /= std::max(weights[index], 1.0f);
+    }
+
+    return output;
+}
+
+}
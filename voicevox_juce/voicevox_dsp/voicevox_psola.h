@@ -0,0 +1,52 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+namespace voicevox
+{
+
+//==============================================================================
+struct VoicevoxPsolaOptions
+{
+    double sampleRate{ 24000.0 };
+    int hopSize{ 256 };
+    double unvoicedPeriodSeconds{ 0.005 };
+
+    // Frames with a lower f0, including NaN, are treated as unvoiced.
+    float minimumF0{ 20.0f };
+};
+
+//==============================================================================
+/**
+    Time domain PSOLA pitch shifter and time stretcher.
+
+    Pitch marks are placed from a frame level f0 contour, such as the one
+    used to render the audio, and refined to the local waveform peak.
+    Unvoiced frames (f0 below minimumF0) are overlap-added with a fixed period
+    and are never pitch shifted.
+*/
+class VoicevoxPsola final
+{
+public:
+    //==============================================================================
+    // Pitch ratios are clamped to this range, non finite ones keep the pitch.
+    static constexpr float minPitchRatio = 0.25f;
+    static constexpr float maxPitchRatio = 4.0f;
+
+    //==============================================================================
+    /** Shifts pitch by a per frame ratio and stretches the length by time_ratio.
+
+        pitch_ratios holds one ratio per f0 frame, pass nullptr to keep the pitch.
+        Output length is round(num_samples * time_ratio).
+    */
+    static std::vector<float> process(const float* input, size_t num_samples,
+                                      const float* f0, size_t num_frames,
+                                      const float* pitch_ratios,
+                                      double time_ratio,
+                                      const VoicevoxPsolaOptions& options = {});
+
+private:
+    VoicevoxPsola() = delete;
+};
+
+}
@@ -1,6 +1,52 @@
 #include "voicevox_juce.h"
 
+//==============================================================================
+// Structured event log
+#include "voicevox_log/voicevox_event_log.cpp"
+
+//==============================================================================
+// Scratch memory for song pipeline
+#include "voicevox_memory/voicevox_frame_arena.cpp"
+
+//==============================================================================
+// Placement of inference and worker threads
+#include "voicevox_threading/voicevox_thread_placement.cpp"
+
 //==============================================================================
 // Hosting object of voicevox_core library
 #include "voicevox_core_host/voicevox_core_host.cpp"
 #include "voicevox_client/voicevox_client.cpp"
+
+//==============================================================================
+// Coalesced rendering of short phrases
+#include "voicevox_batch/voicevox_phrase_batcher.cpp"
+
+//==============================================================================
+// Post processing of rendered audio
+#include "voicevox_dsp/voicevox_audio_kernels.cpp"
+#include "voicevox_dsp/voicevox_psola.cpp"
+
+//==============================================================================
+// Compressed output of rendered audio
+#if VOICEVOX_JUCE_ENABLE_CODEC
+ #include "voicevox_codec/voicevox_stream_encoder.cpp"
+#endif
+
+//==============================================================================
+// Fast audition of song edits
+#include "voicevox_preview/voicevox_song_preview.cpp"
+
+//==============================================================================
+// Rendering ahead of the host playhead
+#include "voicevox_render_ahead/voicevox_render_ahead_engine.cpp"
+
+//==============================================================================
+// Sharing one client between processes
+#include "voicevox_server/voicevox_server_protocol.cpp"
+#include "voicevox_server/voicevox_server.cpp"
+#include "voicevox_server/voicevox_remote_client.cpp"
+
+//==============================================================================
+// Request trace capture and replay
+#include "voicevox_trace/voicevox_trace_recorder.cpp"
+#include "voicevox_trace/voicevox_trace_replayer.cpp"
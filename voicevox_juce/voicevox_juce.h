@@ -29,5 +29,55 @@
 #include <juce_core/juce_core.h>
 
 //==============================================================================
+/** Config: VOICEVOX_JUCE_ENABLE_CODEC
 
+    Enables VoicevoxStreamEncoder. It is built on juce_audio_formats, which has
+    to be added to the project as well, the rest of the module only needs juce_core.
+*/
+#ifndef VOICEVOX_JUCE_ENABLE_CODEC
+ #define VOICEVOX_JUCE_ENABLE_CODEC 0
+#endif
+
+#if VOICEVOX_JUCE_ENABLE_CODEC
+ #include <juce_audio_formats/juce_audio_formats.h>
+#endif
+
+//==============================================================================
+
+#include "voicevox_log/voicevox_event_log.h"
+#include "voicevox_memory/voicevox_frame_arena.h"
+#include "voicevox_threading/voicevox_thread_placement.h"
 #include "voicevox_client/voicevox_client.h"
+
+//==============================================================================
+// Coalesced rendering of short phrases
+#include "voicevox_batch/voicevox_phrase_batcher.h"
+
+//==============================================================================
+// Post processing of rendered audio
+#include "voicevox_dsp/voicevox_audio_kernels.h"
+#include "voicevox_dsp/voicevox_psola.h"
+
+//==============================================================================
+// Compressed output of rendered audio
+#if VOICEVOX_JUCE_ENABLE_CODEC
+ #include "voicevox_codec/voicevox_stream_encoder.h"
+#endif
+
+//==============================================================================
+// Fast audition of song edits
+#include "voicevox_preview/voicevox_song_preview.h"
+
+//==============================================================================
+// Rendering ahead of the host playhead
+#include "voicevox_render_ahead/voicevox_render_ahead_engine.h"
+
+//==============================================================================
+// Sharing one client between processes
+#include "voicevox_server/voicevox_server.h"
+#include "voicevox_server/voicevox_remote_client.h"
+
+//==============================================================================
+// Request trace capture and replay
+#include "voicevox_trace/voicevox_trace_recorder.h"
+#include "voicevox_trace/voicevox_trace_replayer.h"
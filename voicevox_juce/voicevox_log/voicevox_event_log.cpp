@@ -0,0 +1,301 @@
+#include "voicevox_event_log.h"
+
+namespace voicevox
+{
+
+//==============================================================================
+class VoicevoxEventLog::DrainThread final
+    : public juce::Thread
+{
+public:
+    explicit DrainThread(VoicevoxEventLog& owner_to_use)
+        : juce::Thread("voicevox_event_log")
+        , owner(owner_to_use)
+    {
+    }
+
+    ~DrainThread() override
+    {
+        stopThread(1000);
+    }
+
+    void run() override
+    {
+        // NOTE: Producers never signal this thread, waking up a sleeping thread would need a system call on the hot path.
+        while (!threadShouldExit())
+        {
+            owner.drain();
+            wait(20);
+        }
+
+        owner.drain();
+    }
+
+private:
+    VoicevoxEventLog& owner;
+};
+
+//==============================================================================
+VoicevoxEventLog::VoicevoxEventLog()
+    : cells(std::make_unique<Cell[]>(capacity))
+{
+    static_assert(juce::isPowerOfTwo(capacity));
+
+    for (size_t index = 0; index < capacity; index++)
+    {
+        cells[index].sequence.store(index, std::memory_order_relaxed);
+    }
+}
+
+VoicevoxEventLog::~VoicevoxEventLog()
+{
+    // NOTE: A VoicevoxEventLogDrain outlived static destruction, its thread would run on a destroyed log.
+    jassert(drainThread == nullptr);
+}
+
+VoicevoxEventLog& VoicevoxEventLog::getInstance()
+{
+    // NOTE: Owns no thread, see VoicevoxEventLogDrain.
+    static VoicevoxEventLog instance;
+    return instance;
+}
+
+//==============================================================================
+void VoicevoxEventLog::setMinimumLevel(VoicevoxLogLevel level)
+{
+    minimumLevel.store(level, std::memory_order_relaxed);
+    updateDrainThread();
+}
+
+VoicevoxLogLevel VoicevoxEventLog::getMinimumLevel() const noexcept
+{
+    return minimumLevel.load(std::memory_order_relaxed);
+}
+
+void VoicevoxEventLog::setSampleInterval(juce::uint32 interval) noexcept
+{
+    sampleInterval.store(std::max<juce::uint32>(1, interval), std::memory_order_relaxed);
+}
+
+void VoicevoxEventLog::setSink(Sink sink_to_use)
+{
+    const juce::ScopedLock lock(sinkLock);
+    sink = std::move(sink_to_use);
+}
+
+void VoicevoxEventLog::flush()
+{
+    // NOTE: A producer claims its cell before writing the record, pop() stops at a claimed cell that is not published yet.
+    //       Wait for those instead of returning early, producers never block between claiming and publishing.
+    const auto target_position = enqueuePosition.load(std::memory_order_acquire);
+
+    for (;;)
+    {
+        drain();
+
+        if ((std::intptr_t)(target_position - dequeuePosition.load(std::memory_order_acquire)) <= 0)
+        {
+            return;
+        }
+
+        juce::Thread::yield();
+    }
+}
+
+juce::uint64 VoicevoxEventLog::getNumDroppedRecords() const noexcept
+{
+    return numDroppedRecords.load(std::memory_order_relaxed);
+}
+
+//==============================================================================
+void VoicevoxEventLog::setDrainAttached(bool should_be_attached)
+{
+    {
+        const juce::ScopedLock lock(drainThreadLock);
+        isDrainAttached = should_be_attached;
+    }
+
+    updateDrainThread();
+}
+
+void VoicevoxEventLog::updateDrainThread()
+{
+    std::unique_ptr<DrainThread> thread_to_stop;
+
+    {
+        const juce::ScopedLock lock(drainThreadLock);
+
+        const auto should_run = isDrainAttached && getMinimumLevel() != VoicevoxLogLevel::Off;
+        if (should_run && drainThread == nullptr)
+        {
+            drainThread = std::make_unique<DrainThread>(*this);
+            drainThread->startThread();
+        }
+        else if (!should_run && drainThread != nullptr)
+        {
+            thread_to_stop = std::move(drainThread);
+        }
+    }
+
+    // NOTE: Joined outside of the lock, so that other callers don't wait for the final drain.
+    thread_to_stop.reset();
+}
+
+//==============================================================================
+void VoicevoxEventLog::push(VoicevoxLogLevel level, VoicevoxEventId event_id, juce::uint32 speaker_id, juce::int32 result_code, juce::uint32 duration_microseconds, juce::int64 value) noexcept
+{
+    if (level < VoicevoxLogLevel::Warning)
+    {
+        const auto interval = sampleInterval.load(std::memory_order_relaxed);
+        if (interval > 1 && sampleCounter.fetch_add(1, std::memory_order_relaxed) % interval != 0)
+        {
+            return;
+        }
+    }
+
+    // NOTE: Bounded MPMC queue by Dmitry Vyukov, each cell carries the sequence number of the lap it is ready for.
+    auto position = enqueuePosition.load(std::memory_order_relaxed);
+
+    for (;;)
+    {
+        auto& cell = cells[position & (capacity - 1)];
+        const auto sequence = cell.sequence.load(std::memory_order_acquire);
+        const auto difference = (std::intptr_t)sequence - (std::intptr_t)position;
+
+        if (difference == 0)
+        {
+            if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                cell.record.timeTicks = juce::Time::getHighResolutionTicks();
+                cell.record.value = value;
+                cell.record.resultCode = result_code;
+                cell.record.speakerId = speaker_id;
+                cell.record.durationMicroseconds = duration_microseconds;
+                cell.record.eventId = event_id;
+                cell.record.level = level;
+
+                cell.sequence.store(position + 1, std::memory_order_release);
+                return;
+            }
+        }
+        else if (difference < 0)
+        {
+            // NOTE: Drop instead of blocking when the drain thread can't keep up.
+            numDroppedRecords.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        else
+        {
+            position = enqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool VoicevoxEventLog::pop(VoicevoxLogRecord& record) noexcept
+{
+    auto position = dequeuePosition.load(std::memory_order_relaxed);
+
+    for (;;)
+    {
+        auto& cell = cells[position & (capacity - 1)];
+        const auto sequence = cell.sequence.load(std::memory_order_acquire);
+        const auto difference = (std::intptr_t)sequence - (std::intptr_t)(position + 1);
+
+        if (difference == 0)
+        {
+            if (dequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                record = cell.record;
+                cell.sequence.store(position + capacity, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (difference < 0)
+        {
+            return false;
+        }
+        else
+        {
+            position = dequeuePosition.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void VoicevoxEventLog::drain()
+{
+    const juce::ScopedLock lock(sinkLock);
+
+    VoicevoxLogRecord record;
+    while (pop(record))
+    {
+        if (sink != nullptr)
+        {
+            sink(record);
+        }
+        else
+        {
+            juce::Logger::outputDebugString(toString(record));
+        }
+    }
+}
+
+//==============================================================================
+VoicevoxEventLogDrain::VoicevoxEventLogDrain()
+{
+    VoicevoxEventLog::getInstance().setDrainAttached(true);
+}
+
+VoicevoxEventLogDrain::~VoicevoxEventLogDrain()
+{
+    VoicevoxEventLog::getInstance().setDrainAttached(false);
+}
+
+//==============================================================================
+const char* VoicevoxEventLog::getEventName(VoicevoxEventId event_id) noexcept
+{
+    switch (event_id)
+    {
+    case VoicevoxEventId::Connect:                    return "connect";
+    case VoicevoxEventId::Disconnect:                 return "disconnect";
+    case VoicevoxEventId::CoreInitialize:             return "core_initialize";
+    case VoicevoxEventId::LoadModel:                  return "load_model";
+    case VoicevoxEventId::AudioQuery:                 return "audio_query";
+    case VoicevoxEventId::Synthesis:                  return "synthesis";
+    case VoicevoxEventId::Tts:                        return "tts";
+    case VoicevoxEventId::PredictSingConsonantLength: return "predict_sing_consonant_length_forward";
+    case VoicevoxEventId::PredictSingF0:              return "predict_sing_f0_forward";
+    case VoicevoxEventId::PredictSingVolume:          return "predict_sing_volume_forward";
+    case VoicevoxEventId::SfDecode:                   return "sf_decode_forward";
+    case VoicevoxEventId::ServerListening:            return "server_listening";
+    case VoicevoxEventId::ServerUnreachable:          return "server_unreachable";
+    case VoicevoxEventId::NumEventIds:
+    default:                                          return "unknown";
+    }
+}
+
+const char* VoicevoxEventLog::getLevelName(VoicevoxLogLevel level) noexcept
+{
+    switch (level)
+    {
+    case VoicevoxLogLevel::Debug:   return "debug";
+    case VoicevoxLogLevel::Info:    return "info";
+    case VoicevoxLogLevel::Warning: return "warning";
+    case VoicevoxLogLevel::Error:   return "error";
+    case VoicevoxLogLevel::Off:
+    default:                        return "off";
+    }
+}
+
+juce::String VoicevoxEventLog::toString(const VoicevoxLogRecord& record)
+{
+    juce::String text;
+    text << "[voicevox_juce] " << getLevelName(record.level) << " " << getEventName(record.eventId)
+         << " speaker_id=" << (int)record.speakerId
+         << " result_code=" << record.resultCode
+         << " duration_us=" << (juce::int64)record.durationMicroseconds
+         << " value=" << record.value;
+
+    return text;
+}
+
+}
@@ -0,0 +1,224 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+namespace voicevox
+{
+
+//==============================================================================
+enum class VoicevoxLogLevel : juce::uint8
+{
+    Debug = 0,
+    Info,
+    Warning,
+    Error,
+    Off
+};
+
+enum class VoicevoxEventId : juce::uint16
+{
+    Connect = 0,
+    Disconnect,
+    CoreInitialize,
+    LoadModel,
+    AudioQuery,
+    Synthesis,
+    Tts,
+    PredictSingConsonantLength,
+    PredictSingF0,
+    PredictSingVolume,
+    SfDecode,
+    ServerListening,
+    ServerUnreachable,
+    NumEventIds
+};
+
+//==============================================================================
+/** Fixed size log record, never owns heap memory. */
+struct VoicevoxLogRecord
+{
+    juce::int64 timeTicks{ 0 };
+    juce::int64 value{ 0 };
+    juce::int32 resultCode{ 0 };
+    juce::uint32 speakerId{ 0 };
+    juce::uint32 durationMicroseconds{ 0 };
+    VoicevoxEventId eventId{ VoicevoxEventId::Connect };
+    VoicevoxLogLevel level{ VoicevoxLogLevel::Debug };
+};
+
+//==============================================================================
+/**
+    Structured event log of the module.
+
+    Producers push fixed size records into a lock-free multi-producer ring
+    buffer, a background thread drains them to the configured sink. Nothing
+    is allocated or locked on the producer side, and a record below the
+    minimum level costs a single atomic load.
+
+    The instance itself owns no thread. The drain thread runs while a
+    VoicevoxEventLogDrain exists and the minimum level is not Off, so it is
+    stopped with the last VoicevoxClient instead of during static
+    destruction, which is too late inside a plugin.
+
+    The default sink writes to juce::Logger from the background thread.
+*/
+class VoicevoxEventLog final
+{
+public:
+    //==============================================================================
+    using Sink = std::function<void(const VoicevoxLogRecord&)>;
+
+    // Result codes of song API, which only reports success or failure.
+    static constexpr juce::int32 resultFunctionNotFound = -1;
+    static constexpr juce::int32 resultFunctionFailure = -2;
+
+    //==============================================================================
+    static VoicevoxEventLog& getInstance();
+
+    //==============================================================================
+    static void log(VoicevoxLogLevel level, VoicevoxEventId event_id, juce::uint32 speaker_id = 0, juce::int32 result_code = 0, juce::uint32 duration_microseconds = 0, juce::int64 value = 0) noexcept
+    {
+        auto& instance = getInstance();
+
+        if (instance.shouldLog(level))
+        {
+            instance.push(level, event_id, speaker_id, result_code, duration_microseconds, value);
+        }
+    }
+
+    bool shouldLog(VoicevoxLogLevel level) const noexcept
+    {
+        return level >= minimumLevel.load(std::memory_order_relaxed) && level != VoicevoxLogLevel::Off;
+    }
+
+    //==============================================================================
+    // Off also stops the drain thread, the next level that is not Off starts it again.
+    void setMinimumLevel(VoicevoxLogLevel level);
+    VoicevoxLogLevel getMinimumLevel() const noexcept;
+
+    // Keeps one out of every interval records below Warning, 1 keeps everything.
+    void setSampleInterval(juce::uint32 interval) noexcept;
+
+    // Pass nullptr to restore the default sink.
+    void setSink(Sink sink_to_use);
+
+    // Blocks until every record pushed so far has been handed to the sink, drains on the calling thread.
+    void flush();
+
+    juce::uint64 getNumDroppedRecords() const noexcept;
+
+    //==============================================================================
+    static const char* getEventName(VoicevoxEventId event_id) noexcept;
+    static const char* getLevelName(VoicevoxLogLevel level) noexcept;
+    static juce::String toString(const VoicevoxLogRecord& record);
+
+    ~VoicevoxEventLog();
+
+private:
+    //==============================================================================
+    friend class VoicevoxEventLogDrain;
+    class DrainThread;
+
+    VoicevoxEventLog();
+
+    void setDrainAttached(bool should_be_attached);
+    void updateDrainThread();
+
+    void push(VoicevoxLogLevel level, VoicevoxEventId event_id, juce::uint32 speaker_id, juce::int32 result_code, juce::uint32 duration_microseconds, juce::int64 value) noexcept;
+    bool pop(VoicevoxLogRecord& record) noexcept;
+    void drain();
+
+    //==============================================================================
+    struct Cell
+    {
+        std::atomic<size_t> sequence{ 0 };
+        VoicevoxLogRecord record{};
+    };
+
+    static constexpr size_t capacity = 4096;
+
+    std::unique_ptr<Cell[]> cells;
+    alignas(64) std::atomic<size_t> enqueuePosition{ 0 };
+    alignas(64) std::atomic<size_t> dequeuePosition{ 0 };
+
+    std::atomic<VoicevoxLogLevel> minimumLevel{ VoicevoxLogLevel::Info };
+    std::atomic<juce::uint32> sampleInterval{ 1 };
+    std::atomic<juce::uint32> sampleCounter{ 0 };
+    std::atomic<juce::uint64> numDroppedRecords{ 0 };
+
+    juce::CriticalSection sinkLock;
+    Sink sink;
+
+    juce::CriticalSection drainThreadLock;
+    bool isDrainAttached{ false };
+    std::unique_ptr<DrainThread> drainThread;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VoicevoxEventLog)
+};
+
+//==============================================================================
+/**
+    Keeps the drain thread of VoicevoxEventLog running while it exists.
+
+    Shared through SharedVoicevoxEventLogDrain by every VoicevoxClient and
+    VoicevoxRemoteClient, the thread is joined when the last one is deleted.
+    Records logged while none exists stay queued until the next one is
+    created or flush() is called.
+*/
+class VoicevoxEventLogDrain final
+{
+public:
+    VoicevoxEventLogDrain();
+    ~VoicevoxEventLogDrain();
+
+private:
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VoicevoxEventLogDrain)
+};
+
+using SharedVoicevoxEventLogDrain = juce::SharedResourcePointer<VoicevoxEventLogDrain>;
+
+//==============================================================================
+/**
+    Logs one event with its duration when going out of scope.
+
+    Successful events are logged at Debug level, failed ones at Error level.
+*/
+class VoicevoxScopedEventTimer final
+{
+public:
+    explicit VoicevoxScopedEventTimer(VoicevoxEventId event_id, juce::uint32 speaker_id = 0) noexcept
+        : eventId(event_id)
+        , speakerId(speaker_id)
+        , startTicks(VoicevoxEventLog::getInstance().shouldLog(VoicevoxLogLevel::Error) ? juce::Time::getHighResolutionTicks() : 0)
+    {
+    }
+
+    ~VoicevoxScopedEventTimer()
+    {
+        if (startTicks == 0)
+        {
+            return;
+        }
+
+        const auto level = resultCode == 0 ? VoicevoxLogLevel::Debug : VoicevoxLogLevel::Error;
+        if (!VoicevoxEventLog::getInstance().shouldLog(level))
+        {
+            return;
+        }
+
+        const auto elapsed_seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+        VoicevoxEventLog::log(level, eventId, speakerId, resultCode, (juce::uint32)std::min(elapsed_seconds * 1.0e6, 4.0e9));
+    }
+
+    void setResultCode(juce::int32 result_code) noexcept { resultCode = result_code; }
+
+private:
+    const VoicevoxEventId eventId;
+    const juce::uint32 speakerId;
+    const juce::int64 startTicks;
+    juce::int32 resultCode{ 0 };
+
+    JUCE_DECLARE_NON_COPYABLE(VoicevoxScopedEventTimer)
+};
+
+}
@@ -0,0 +1,132 @@
+#include "voicevox_frame_arena.h"
+
+namespace voicevox
+{
+
+std::atomic<bool> VoicevoxFrameArena::shouldFirstTouchNewBlocks{ false };
+
+//==============================================================================
+VoicevoxFrameArena::VoicevoxFrameArena(size_t initial_capacity_bytes)
+    : currentBlockIndex(0)
+    , currentOffset(0)
+{
+    addBlock(std::max(initial_capacity_bytes, defaultAlignment));
+}
+
+VoicevoxFrameArena::~VoicevoxFrameArena()
+{
+}
+
+//==============================================================================
+void* VoicevoxFrameArena::allocateBytes(size_t num_bytes, size_t alignment)
+{
+    jassert(juce::isPowerOfTwo(alignment));
+
+    const auto try_allocate_in_block = [&](size_t block_index) -> void* {
+        auto& block = blocks[block_index];
+        const auto base_address = reinterpret_cast<std::uintptr_t>(block.memory.get());
+        const auto offset = block_index == currentBlockIndex ? currentOffset : 0;
+        const auto aligned_address = (base_address + offset + alignment - 1) & ~(std::uintptr_t)(alignment - 1);
+        const auto aligned_offset = (size_t)(aligned_address - base_address);
+
+        if (aligned_offset + num_bytes > block.capacity)
+        {
+            return nullptr;
+        }
+
+        statistics.bytesInUse += (aligned_offset - offset) + num_bytes;
+        currentBlockIndex = block_index;
+        currentOffset = aligned_offset + num_bytes;
+
+        return block.memory.get() + aligned_offset;
+    };
+
+    void* memory = nullptr;
+
+    for (auto block_index = currentBlockIndex; block_index < blocks.size() && memory == nullptr; block_index++)
+    {
+        memory = try_allocate_in_block(block_index);
+    }
+
+    if (memory == nullptr)
+    {
+        addBlock(std::max(num_bytes + alignment, blocks.back().capacity * 2));
+        memory = try_allocate_in_block(blocks.size() - 1);
+    }
+
+    jassert(memory != nullptr);
+
+    statistics.numAllocations++;
+    statistics.highWaterMarkBytes = std::max(statistics.highWaterMarkBytes, statistics.bytesInUse);
+
+    return memory;
+}
+
+void VoicevoxFrameArena::reset()
+{
+    // NOTE: Merge blocks into one so that the next job of the same size never has to grow the arena.
+    if (blocks.size() > 1)
+    {
+        size_t total_capacity = 0;
+        for (const auto& block : blocks)
+        {
+            total_capacity += block.capacity;
+        }
+
+        blocks.clear();
+        statistics.capacityBytes = 0;
+        statistics.numBlocks = 0;
+
+        addBlock(total_capacity);
+    }
+
+    currentBlockIndex = 0;
+    currentOffset = 0;
+
+    statistics.bytesInUse = 0;
+    statistics.numResets++;
+}
+
+//==============================================================================
+VoicevoxFrameArena::Statistics VoicevoxFrameArena::getStatistics() const
+{
+    return statistics;
+}
+
+VoicevoxFrameArena& VoicevoxFrameArena::getThreadLocalArena()
+{
+    thread_local VoicevoxFrameArena thread_local_arena;
+    return thread_local_arena;
+}
+
+void VoicevoxFrameArena::setFirstTouchNewBlocks(bool should_touch) noexcept
+{
+    shouldFirstTouchNewBlocks.store(should_touch, std::memory_order_relaxed);
+}
+
+//==============================================================================
+void VoicevoxFrameArena::addBlock(size_t capacity)
+{
+    Block block;
+    block.memory.malloc(capacity);
+    block.capacity = capacity;
+
+    if (shouldFirstTouchNewBlocks.load(std::memory_order_relaxed))
+    {
+        constexpr size_t page_size = 4096;
+
+        // NOTE: Volatile keeps the compiler from dropping writes to memory nobody reads yet.
+        volatile char* memory = block.memory.get();
+        for (size_t offset = 0; offset < capacity; offset += page_size)
+        {
+            memory[offset] = 0;
+        }
+    }
+
+    blocks.push_back(std::move(block));
+
+    statistics.capacityBytes += capacity;
+    statistics.numBlocks = blocks.size();
+}
+
+}
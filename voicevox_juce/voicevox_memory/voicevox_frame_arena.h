@@ -0,0 +1,134 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+namespace voicevox
+{
+
+//==============================================================================
+/**
+    Non-owning view of frame data.
+
+    Used to pass arena backed buffers between song stages without copying.
+*/
+template <typename ElementType>
+class VoicevoxFrameSpan final
+{
+public:
+    //==============================================================================
+    VoicevoxFrameSpan() = default;
+
+    VoicevoxFrameSpan(ElementType* data_to_use, size_t num_elements)
+        : elements(data_to_use)
+        , numElements(num_elements)
+    {
+    }
+
+    template <typename ContainerType,
+              typename = std::enable_if_t<std::is_convertible_v<decltype(std::declval<ContainerType&>().data()), ElementType*>>>
+    VoicevoxFrameSpan(ContainerType& container)
+        : elements(container.data())
+        , numElements(container.size())
+    {
+    }
+
+    //==============================================================================
+    ElementType* data() const noexcept { return elements; }
+    size_t size() const noexcept { return numElements; }
+    bool empty() const noexcept { return numElements == 0; }
+
+    ElementType* begin() const noexcept { return elements; }
+    ElementType* end() const noexcept { return elements + numElements; }
+
+    ElementType& operator[](size_t index) const noexcept
+    {
+        jassert(index < numElements);
+        return elements[index];
+    }
+
+    std::vector<std::remove_const_t<ElementType>> toVector() const
+    {
+        return std::vector<std::remove_const_t<ElementType>>(begin(), end());
+    }
+
+private:
+    //==============================================================================
+    ElementType* elements{ nullptr };
+    size_t numElements{ 0 };
+};
+
+//==============================================================================
+/**
+    Bump allocator for the intermediate frame buffers of one song render job.
+
+    Every allocation is released at once by reset(). When a job needed more
+    than one block, the blocks are merged on reset so that the next job of the
+    same size is served from a single block without touching the system heap.
+
+    This class is not thread safe, use one arena per job or per thread.
+*/
+class VoicevoxFrameArena final
+{
+public:
+    //==============================================================================
+    struct Statistics
+    {
+        size_t bytesInUse{ 0 };
+        size_t highWaterMarkBytes{ 0 };
+        size_t capacityBytes{ 0 };
+        size_t numBlocks{ 0 };
+        size_t numAllocations{ 0 };
+        size_t numResets{ 0 };
+    };
+
+    //==============================================================================
+    explicit VoicevoxFrameArena(size_t initial_capacity_bytes = 1024 * 1024);
+    ~VoicevoxFrameArena();
+
+    //==============================================================================
+    template <typename ElementType>
+    VoicevoxFrameSpan<ElementType> allocate(size_t num_elements)
+    {
+        static_assert(std::is_trivially_copyable_v<ElementType>);
+
+        auto* memory = allocateBytes(num_elements * sizeof(ElementType), std::max<size_t>(alignof(ElementType), defaultAlignment));
+        return VoicevoxFrameSpan<ElementType>(static_cast<ElementType*>(memory), num_elements);
+    }
+
+    void* allocateBytes(size_t num_bytes, size_t alignment = defaultAlignment);
+    void reset();
+
+    //==============================================================================
+    Statistics getStatistics() const;
+
+    static VoicevoxFrameArena& getThreadLocalArena();
+
+    // Writes every page of a new block from the allocating thread, so that the first-touch policy of the OS
+    // places the block on the NUMA node of that thread instead of the one of the thread writing to it first.
+    static void setFirstTouchNewBlocks(bool should_touch) noexcept;
+
+    static constexpr size_t defaultAlignment = 64;
+
+private:
+    //==============================================================================
+    struct Block
+    {
+        juce::HeapBlock<char> memory;
+        size_t capacity{ 0 };
+    };
+
+    void addBlock(size_t capacity);
+
+    static std::atomic<bool> shouldFirstTouchNewBlocks;
+
+    //==============================================================================
+    std::vector<Block> blocks;
+    size_t currentBlockIndex;
+    size_t currentOffset;
+
+    Statistics statistics;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VoicevoxFrameArena)
+};
+
+}
@@ -0,0 +1,283 @@
+#include "voicevox_song_preview.h"
+#include "../voicevox_client/voicevox_client.h"
+#include "../voicevox_core_host/voicevox_core_host.h"
+#include "../voicevox_dsp/voicevox_psola.h"
+#include "../voicevox_threading/voicevox_thread_placement.h"
+
+namespace voicevox
+{
+
+//==============================================================================
+struct VoicevoxSongPreview::PhraseState
+{
+    // Immutable after creation.
+    juce::uint32 speakerId{ 0 };
+    VoicevoxSfDecodeSource decodeSource{};
+    std::vector<float> renderedAudio{};
+
+    // Guarded by phraseLock.
+    VoicevoxPreviewEdit currentEdit{};
+    std::vector<float> previewAudio{};
+    std::vector<float> fullQualityAudio{};
+    bool isFullQuality{ true };
+    juce::int64 generation{ 0 };
+};
+
+//==============================================================================
+VoicevoxSongPreview::VoicevoxSongPreview(VoicevoxClient& client)
+    : voicevoxClient(client)
+    , renderThreadPool(1)
+{
+}
+
+VoicevoxSongPreview::~VoicevoxSongPreview()
+{
+    // NOTE: No timeout, a queued re-render holds this object until its core call returns.
+    renderThreadPool.removeAllJobs(true, -1);
+}
+
+//==============================================================================
+void VoicevoxSongPreview::setRenderedPhrase(int phrase_id, juce::uint32 speaker_id, const VoicevoxSfDecodeSource& decode_source, std::vector<float> rendered_audio)
+{
+    jassert(decode_source.f0Vector.size() == decode_source.phonemeVector.size());
+    jassert(decode_source.f0Vector.size() == decode_source.volumeVector.size());
+
+    auto state = std::make_shared<PhraseState>();
+    state->speakerId = speaker_id;
+    state->decodeSource = decode_source;
+    state->renderedAudio = std::move(rendered_audio);
+    state->fullQualityAudio = state->renderedAudio;
+
+    const juce::ScopedLock lock(phraseLock);
+    phrases[phrase_id] = std::move(state);
+}
+
+void VoicevoxSongPreview::removePhrase(int phrase_id)
+{
+    const juce::ScopedLock lock(phraseLock);
+    phrases.erase(phrase_id);
+}
+
+void VoicevoxSongPreview::clear()
+{
+    const juce::ScopedLock lock(phraseLock);
+    phrases.clear();
+}
+
+//==============================================================================
+std::optional<std::vector<float>> VoicevoxSongPreview::audition(int phrase_id, const VoicevoxPreviewEdit& edit)
+{
+    std::shared_ptr<PhraseState> state;
+
+    {
+        const juce::ScopedLock lock(phraseLock);
+
+        const auto found = phrases.find(phrase_id);
+        if (found == phrases.end())
+        {
+            return std::nullopt;
+        }
+
+        state = found->second;
+    }
+
+    const auto& source_f0 = state->decodeSource.f0Vector;
+    const auto pitch_ratios = makePitchRatios(source_f0, edit);
+    const auto sample_rate = voicevoxClient.getSampleRate();
+
+    VoicevoxPsolaOptions options;
+    options.sampleRate = sample_rate > 0.0 ? sample_rate : options.sampleRate;
+    options.hopSize = (int)VoicevoxCoreHost::samplesPerFrame;
+
+    // NOTE: The re-render is a whole number of frames, stretch the preview to exactly that length
+    //       so that swapping in the full quality audio never changes the phrase length.
+    const auto num_preview_samples = getStretchedNumFrames(source_f0.size(), edit.timeStretchRatio) * VoicevoxCoreHost::samplesPerFrame;
+    const auto time_ratio = state->renderedAudio.empty() ? edit.timeStretchRatio : (double)num_preview_samples / (double)state->renderedAudio.size();
+
+    auto preview_audio = VoicevoxPsola::process(state->renderedAudio.data(), state->renderedAudio.size(),
+                                                source_f0.data(), source_f0.size(),
+                                                pitch_ratios.data(),
+                                                time_ratio,
+                                                options);
+
+    // NOTE: Guards against rounding when the cached render is not a whole number of frames.
+    preview_audio.resize(num_preview_samples, 0.0f);
+
+    juce::int64 generation = 0;
+
+    {
+        const juce::ScopedLock lock(phraseLock);
+
+        state->currentEdit = edit;
+        state->previewAudio = preview_audio;
+        state->fullQualityAudio.clear();
+        state->isFullQuality = false;
+        generation = ++state->generation;
+    }
+
+    // NOTE: Older jobs of the same phrase notice the generation change and return immediately.
+    renderThreadPool.addJob([this, phrase_id, generation] { renderInBackground(phrase_id, generation); });
+
+    return preview_audio;
+}
+
+std::optional<std::vector<float>> VoicevoxSongPreview::getAudio(int phrase_id) const
+{
+    const juce::ScopedLock lock(phraseLock);
+
+    const auto found = phrases.find(phrase_id);
+    if (found == phrases.end())
+    {
+        return std::nullopt;
+    }
+
+    const auto& state = *found->second;
+    return state.isFullQuality ? state.fullQualityAudio : state.previewAudio;
+}
+
+bool VoicevoxSongPreview::isFullQuality(int phrase_id) const
+{
+    const juce::ScopedLock lock(phraseLock);
+
+    const auto found = phrases.find(phrase_id);
+    return found != phrases.end() && found->second->isFullQuality;
+}
+
+//==============================================================================
+void VoicevoxSongPreview::renderInBackground(int phrase_id, juce::int64 generation)
+{
+    VoicevoxThreadPlacement::applyInferenceAffinity();
+
+    std::shared_ptr<PhraseState> state;
+    VoicevoxPreviewEdit edit;
+
+    {
+        const juce::ScopedLock lock(phraseLock);
+
+        const auto found = phrases.find(phrase_id);
+        if (found == phrases.end() || found->second->generation != generation)
+        {
+            return;
+        }
+
+        state = found->second;
+        edit = state->currentEdit;
+    }
+
+    auto decode_source = state->decodeSource;
+    applyEditToDecodeSource(decode_source, edit);
+
+    auto rendered_audio = voicevoxClient.singBySfDecode(state->speakerId, decode_source);
+    if (!rendered_audio.has_value())
+    {
+        return;
+    }
+
+    {
+        const juce::ScopedLock lock(phraseLock);
+
+        const auto found = phrases.find(phrase_id);
+        if (found == phrases.end() || found->second != state || state->generation != generation)
+        {
+            return;
+        }
+
+        state->fullQualityAudio = std::move(*rendered_audio);
+        state->isFullQuality = true;
+    }
+
+    if (onFullRenderReady != nullptr)
+    {
+        onFullRenderReady(phrase_id);
+    }
+}
+
+//==============================================================================
+std::vector<float> VoicevoxSongPreview::makePitchRatios(const std::vector<float>& source_f0, const VoicevoxPreviewEdit& edit)
+{
+    const auto shift_ratio = std::pow(2.0f, edit.pitchShiftSemitones / 12.0f);
+
+    std::vector<float> pitch_ratios(source_f0.size(), shift_ratio);
+
+    for (size_t index = 0; index < std::min(source_f0.size(), edit.targetF0.size()); index++)
+    {
+        if (source_f0[index] > 0.0f && edit.targetF0[index] > 0.0f)
+        {
+            pitch_ratios[index] *= edit.targetF0[index] / source_f0[index];
+        }
+    }
+
+    // NOTE: Clamped the same way as VoicevoxPsola does, so that the full quality render matches the preview.
+    for (auto& pitch_ratio : pitch_ratios)
+    {
+        pitch_ratio = std::isfinite(pitch_ratio) ? juce::jlimit(VoicevoxPsola::minPitchRatio, VoicevoxPsola::maxPitchRatio, pitch_ratio) : 1.0f;
+    }
+
+    return pitch_ratios;
+}
+
+size_t VoicevoxSongPreview::getStretchedNumFrames(size_t num_frames, double time_stretch_ratio)
+{
+    if (num_frames == 0 || time_stretch_ratio == 1.0)
+    {
+        return num_frames;
+    }
+
+    return (size_t)std::max<long long>(1, std::llround((double)num_frames * time_stretch_ratio));
+}
+
+void VoicevoxSongPreview::applyEditToDecodeSource(VoicevoxSfDecodeSource& decode_source, const VoicevoxPreviewEdit& edit)
+{
+    auto& f0 = decode_source.f0Vector;
+    const auto pitch_ratios = makePitchRatios(f0, edit);
+
+    for (size_t index = 0; index < f0.size(); index++)
+    {
+        // NOTE: Unvoiced frames stay unvoiced regardless of the edit.
+        if (f0[index] > 0.0f)
+        {
+            f0[index] *= pitch_ratios[index];
+        }
+    }
+
+    const auto num_frames = f0.size();
+    if (num_frames == 0 || edit.timeStretchRatio == 1.0)
+    {
+        return;
+    }
+
+    const auto num_stretched_frames = getStretchedNumFrames(num_frames, edit.timeStretchRatio);
+
+    VoicevoxSfDecodeSource stretched;
+    stretched.f0Vector.resize(num_stretched_frames);
+    stretched.volumeVector.resize(num_stretched_frames);
+    stretched.phonemeVector.resize(num_stretched_frames);
+
+    for (size_t index = 0; index < num_stretched_frames; index++)
+    {
+        const auto source_position = juce::jlimit(0.0, (double)(num_frames - 1), ((double)index + 0.5) / edit.timeStretchRatio - 0.5);
+        const auto lower = (size_t)source_position;
+        const auto upper = std::min(lower + 1, num_frames - 1);
+        const auto fraction = (float)(source_position - (double)lower);
+        const auto nearest = fraction < 0.5f ? lower : upper;
+
+        stretched.phonemeVector[index] = decode_source.phonemeVector[nearest];
+        stretched.volumeVector[index] = decode_source.volumeVector[lower] + (decode_source.volumeVector[upper] - decode_source.volumeVector[lower]) * fraction;
+
+        // NOTE: Interpolate f0 only inside voiced regions to keep voicing boundaries sharp.
+        if (f0[lower] > 0.0f && f0[upper] > 0.0f)
+        {
+            stretched.f0Vector[index] = f0[lower] + (f0[upper] - f0[lower]) * fraction;
+        }
+        else
+        {
+            stretched.f0Vector[index] = f0[nearest];
+        }
+    }
+
+    decode_source.f0Vector = std::move(stretched.f0Vector);
+    decode_source.volumeVector = std::move(stretched.volumeVector);
+    decode_source.phonemeVector = std::move(stretched.phonemeVector);
+}
+
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+namespace voicevox
+{
+
+class VoicevoxClient;
+struct VoicevoxSfDecodeSource;
+
+//==============================================================================
+struct VoicevoxPreviewEdit
+{
+    // Uniform pitch offset, applied on top of targetF0 when it is given.
+    float pitchShiftSemitones{ 0.0f };
+
+    // Output length relative to the cached render.
+    double timeStretchRatio{ 1.0 };
+
+    // Optional edited f0 contour, frame aligned with the cached render.
+    std::vector<float> targetF0{};
+};
+
+//==============================================================================
+/**
+    Fast audition of pitch / tempo edits on already rendered song phrases.
+
+    audition() applies the edit to the cached render with PSOLA, using the f0
+    contour of the render as analysis hints, and returns within a few
+    milliseconds. A full quality sf_decode_forward re-render of the same edit
+    is queued in background and swapped in once it is ready.
+
+    Edits are always applied to the original render, so repeated nudges never
+    accumulate DSP artifacts.
+*/
+class VoicevoxSongPreview final
+{
+public:
+    //==============================================================================
+    explicit VoicevoxSongPreview(VoicevoxClient& client);
+    ~VoicevoxSongPreview();
+
+    //==============================================================================
+    void setRenderedPhrase(int phrase_id, juce::uint32 speaker_id, const VoicevoxSfDecodeSource& decode_source, std::vector<float> rendered_audio);
+    void removePhrase(int phrase_id);
+    void clear();
+
+    //==============================================================================
+    std::optional<std::vector<float>> audition(int phrase_id, const VoicevoxPreviewEdit& edit);
+
+    // Full quality render once available, otherwise the latest preview.
+    std::optional<std::vector<float>> getAudio(int phrase_id) const;
+    bool isFullQuality(int phrase_id) const;
+
+    //==============================================================================
+    // Called from the background render thread.
+    std::function<void(int phrase_id)> onFullRenderReady;
+
+    //==============================================================================
+    static std::vector<float> makePitchRatios(const std::vector<float>& source_f0, const VoicevoxPreviewEdit& edit);
+    static void applyEditToDecodeSource(VoicevoxSfDecodeSource& decode_source, const VoicevoxPreviewEdit& edit);
+
+    // Frame count of the re-render, the preview is stretched to the same number of samples.
+    static size_t getStretchedNumFrames(size_t num_frames, double time_stretch_ratio);
+
+private:
+    //==============================================================================
+    struct PhraseState;
+
+    void renderInBackground(int phrase_id, juce::int64 generation);
+
+    //==============================================================================
+    VoicevoxClient& voicevoxClient;
+
+    mutable juce::CriticalSection phraseLock;
+    std::map<int, std::shared_ptr<PhraseState>> phrases;
+
+    juce::ThreadPool renderThreadPool;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VoicevoxSongPreview)
+};
+
+}
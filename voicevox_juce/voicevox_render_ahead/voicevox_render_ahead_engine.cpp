@@ -0,0 +1,429 @@
+#include "voicevox_render_ahead_engine.h"
+#include "../voicevox_client/voicevox_client.h"
+#include "../voicevox_core_host/voicevox_core_host.h"
+#include "../voicevox_threading/voicevox_thread_placement.h"
+
+namespace voicevox
+{
+
+//==============================================================================
+struct VoicevoxRenderAheadEngine::Phrase
+{
+    double startPpq{ 0.0 };
+    double durationSeconds{ 0.0 };
+    juce::uint32 speakerId{ 0 };
+    std::shared_ptr<const VoicevoxSfDecodeSource> decodeSource{};
+
+    // A render result is accepted only when its generation still matches.
+    juce::int64 generation{ 0 };
+    std::shared_ptr<const std::vector<float>> renderedAudio{};
+    bool isRendering{ false };
+    bool hasRenderFailed{ false };
+    bool isDeadlineMissReported{ false };
+};
+
+//==============================================================================
+class VoicevoxRenderAheadEngine::Scheduler final
+    : public juce::Thread
+{
+public:
+    Scheduler(VoicevoxRenderAheadEngine& owner_to_use, int interval_milliseconds)
+        : juce::Thread("voicevox_render_ahead")
+        , owner(owner_to_use)
+        , intervalMilliseconds(std::max(1, interval_milliseconds))
+    {
+        startThread();
+    }
+
+    ~Scheduler() override
+    {
+        stopThread(10000);
+    }
+
+    void run() override
+    {
+        VoicevoxThreadPlacement::applyWorkerAffinity();
+
+        while (!threadShouldExit())
+        {
+            owner.schedule();
+            wait(intervalMilliseconds);
+        }
+    }
+
+private:
+    VoicevoxRenderAheadEngine& owner;
+    const int intervalMilliseconds;
+};
+
+//==============================================================================
+VoicevoxRenderAheadEngine::VoicevoxRenderAheadEngine(VoicevoxClient& client, const VoicevoxRenderAheadOptions& options_to_use)
+    : voicevoxClient(client)
+    , options(options_to_use)
+    , nextGeneration(1)
+    , lastSeekCounter(0)
+    , lastIsConnected(false)
+    , renderThreadPool(std::max(1, options_to_use.numRenderThreads))
+    , previousTransportPpq(0.0)
+{
+    renderedAudioSnapshot = std::make_shared<const RenderedAudioSnapshot>();
+    scheduler = std::make_unique<Scheduler>(*this, options.schedulerIntervalMilliseconds);
+}
+
+VoicevoxRenderAheadEngine::~VoicevoxRenderAheadEngine()
+{
+    // NOTE: Stop scheduling first, then wait for renders in flight which still notify the scheduler object.
+    //       No timeout, a render job holds this object until its core call returns.
+    scheduler->stopThread(-1);
+    renderThreadPool.removeAllJobs(true, -1);
+    scheduler.reset();
+}
+
+//==============================================================================
+void VoicevoxRenderAheadEngine::setPhrase(int phrase_id, double start_ppq, juce::uint32 speaker_id, const VoicevoxSfDecodeSource& decode_source)
+{
+    const auto sample_rate = voicevoxClient.getSampleRate() > 0.0 ? voicevoxClient.getSampleRate() : 24000.0;
+
+    auto phrase = std::make_shared<Phrase>();
+    phrase->startPpq = start_ppq;
+    phrase->durationSeconds = (double)(decode_source.f0Vector.size() * VoicevoxCoreHost::samplesPerFrame) / sample_rate;
+    phrase->speakerId = speaker_id;
+    phrase->decodeSource = std::make_shared<const VoicevoxSfDecodeSource>(decode_source);
+
+    std::shared_ptr<Phrase> replaced_phrase;
+
+    {
+        const juce::SpinLock::ScopedLockType lock(phraseLock);
+
+        phrase->generation = nextGeneration++;
+
+        auto& slot = phrases[phrase_id];
+        replaced_phrase = std::move(slot);
+        slot = std::move(phrase);
+
+        if (replaced_phrase != nullptr && replaced_phrase->renderedAudio != nullptr)
+        {
+            publishRenderedAudio();
+        }
+    }
+
+    clearRenderFailures();
+    scheduler->notify();
+}
+
+void VoicevoxRenderAheadEngine::removePhrase(int phrase_id)
+{
+    std::shared_ptr<Phrase> removed_phrase;
+
+    {
+        const juce::SpinLock::ScopedLockType lock(phraseLock);
+
+        const auto found = phrases.find(phrase_id);
+        if (found == phrases.end())
+        {
+            return;
+        }
+
+        removed_phrase = std::move(found->second);
+        phrases.erase(found);
+
+        if (removed_phrase->renderedAudio != nullptr)
+        {
+            publishRenderedAudio();
+        }
+    }
+
+    clearRenderFailures();
+}
+
+void VoicevoxRenderAheadEngine::clearPhrases()
+{
+    std::map<int, std::shared_ptr<Phrase>> removed_phrases;
+
+    {
+        const juce::SpinLock::ScopedLockType lock(phraseLock);
+        std::swap(removed_phrases, phrases);
+        publishRenderedAudio();
+    }
+}
+
+//==============================================================================
+void VoicevoxRenderAheadEngine::updateTransport(double ppq_position, double bpm, bool is_playing) noexcept
+{
+    // NOTE: Any backward move, or a forward jump longer than half a second, is handled as a seek.
+    const auto delta_ppq = ppq_position - previousTransportPpq;
+    const auto max_forward_ppq = 0.5 * std::max(1.0, bpm) / 60.0;
+
+    if (delta_ppq < -1.0e-6 || delta_ppq > max_forward_ppq)
+    {
+        seekCounter.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    previousTransportPpq = ppq_position;
+
+    transportPpq.store(ppq_position, std::memory_order_relaxed);
+    transportBpm.store(bpm, std::memory_order_relaxed);
+    transportIsPlaying.store(is_playing, std::memory_order_relaxed);
+}
+
+std::shared_ptr<const std::vector<float>> VoicevoxRenderAheadEngine::getRenderedAudio(int phrase_id) const noexcept
+{
+    const auto snapshot = std::atomic_load(&renderedAudioSnapshot);
+
+    const auto found = std::lower_bound(snapshot->begin(), snapshot->end(), phrase_id,
+        [](const auto& entry, int id) { return entry.first < id; });
+
+    if (found == snapshot->end() || found->first != phrase_id)
+    {
+        return nullptr;
+    }
+
+    return found->second;
+}
+
+//==============================================================================
+VoicevoxRenderAheadEngine::Statistics VoicevoxRenderAheadEngine::getStatistics() const noexcept
+{
+    Statistics statistics;
+    statistics.numRendersCompleted = numRendersCompleted.load();
+    statistics.numRendersDiscarded = numRendersDiscarded.load();
+    statistics.numRendersFailed = numRendersFailed.load();
+    statistics.numDeadlineMisses = numDeadlineMisses.load();
+    statistics.numSeeks = seekCounter.load();
+
+    return statistics;
+}
+
+//==============================================================================
+// NOTE: Called with phraseLock held, whenever the rendered audio of a phrase is set or dropped.
+void VoicevoxRenderAheadEngine::publishRenderedAudio()
+{
+    auto snapshot = std::make_shared<RenderedAudioSnapshot>();
+
+    // NOTE: phrases is ordered by id, so the snapshot comes out sorted.
+    for (const auto& [phrase_id, phrase] : phrases)
+    {
+        if (phrase->renderedAudio != nullptr)
+        {
+            snapshot->emplace_back(phrase_id, phrase->renderedAudio);
+        }
+    }
+
+    retiredRenderedAudioSnapshot = std::atomic_exchange(&renderedAudioSnapshot, std::shared_ptr<const RenderedAudioSnapshot>(std::move(snapshot)));
+}
+
+void VoicevoxRenderAheadEngine::clearRenderFailures()
+{
+    const juce::SpinLock::ScopedLockType lock(phraseLock);
+
+    for (auto& [phrase_id, phrase] : phrases)
+    {
+        phrase->hasRenderFailed = false;
+    }
+}
+
+void VoicevoxRenderAheadEngine::schedule()
+{
+    struct RenderCandidate
+    {
+        double distanceSeconds;
+        int phraseId;
+        juce::int64 generation;
+        juce::uint32 speakerId;
+        std::shared_ptr<const VoicevoxSfDecodeSource> decodeSource;
+    };
+
+    const auto ppq_position = transportPpq.load(std::memory_order_relaxed);
+    const auto seconds_per_quarter = 60.0 / std::max(1.0, transportBpm.load(std::memory_order_relaxed));
+    const auto is_playing = transportIsPlaying.load(std::memory_order_relaxed);
+
+    const auto seek_counter = seekCounter.load(std::memory_order_relaxed);
+    const auto has_seeked = seek_counter != lastSeekCounter;
+    lastSeekCounter = seek_counter;
+
+    // NOTE: A failure may come from the connection, retry every phrase once it changed.
+    const auto is_connected = voicevoxClient.isConnected();
+    const auto has_connection_changed = is_connected != lastIsConnected;
+    lastIsConnected = is_connected;
+
+    // Renders whose result will still be accepted, stale ones run to completion without taking a slot.
+    int num_renders_in_flight = 0;
+
+    std::vector<RenderCandidate> candidates;
+    std::vector<int> missed_phrase_ids;
+    std::vector<std::shared_ptr<const std::vector<float>>> evicted_audio;
+
+    {
+        const juce::SpinLock::ScopedLockType lock(phraseLock);
+
+        for (auto& [phrase_id, phrase] : phrases)
+        {
+            const auto start_seconds = (phrase->startPpq - ppq_position) * seconds_per_quarter;
+            const auto end_seconds = start_seconds + phrase->durationSeconds;
+
+            const auto is_in_render_window = end_seconds >= -options.lookBehindSeconds && start_seconds <= options.lookAheadSeconds;
+            const auto is_in_keep_window = end_seconds >= -2.0 * options.lookBehindSeconds && start_seconds <= 2.0 * options.lookAheadSeconds;
+
+            if (has_seeked && start_seconds > 0.0)
+            {
+                phrase->isDeadlineMissReported = false;
+            }
+
+            if (has_connection_changed)
+            {
+                phrase->hasRenderFailed = false;
+            }
+
+            if (!is_in_render_window && phrase->isRendering)
+            {
+                // NOTE: The core call can't be interrupted, bump the generation so that its result is thrown away.
+                phrase->generation = nextGeneration++;
+                phrase->isRendering = false;
+            }
+
+            if (phrase->isRendering)
+            {
+                num_renders_in_flight++;
+            }
+
+            if (!is_in_keep_window && phrase->renderedAudio != nullptr)
+            {
+                evicted_audio.push_back(std::move(phrase->renderedAudio));
+            }
+
+            if (!is_in_render_window)
+            {
+                continue;
+            }
+
+            const auto is_sounding = start_seconds <= 0.0 && end_seconds > 0.0;
+            if (is_playing && is_sounding && phrase->renderedAudio == nullptr && !phrase->isDeadlineMissReported)
+            {
+                phrase->isDeadlineMissReported = true;
+                missed_phrase_ids.push_back(phrase_id);
+            }
+
+            if (is_connected && phrase->renderedAudio == nullptr && !phrase->isRendering && !phrase->hasRenderFailed)
+            {
+                // NOTE: Phrases already behind the playhead are only rendered after everything ahead of it.
+                const auto distance_seconds = start_seconds >= 0.0 ? start_seconds
+                                            : is_sounding          ? 0.0
+                                                                   : options.lookAheadSeconds - end_seconds;
+
+                candidates.push_back({ distance_seconds, phrase_id, phrase->generation, phrase->speakerId, phrase->decodeSource });
+            }
+        }
+
+        if (!evicted_audio.empty())
+        {
+            publishRenderedAudio();
+        }
+    }
+
+    numDeadlineMisses += (juce::uint64)missed_phrase_ids.size();
+
+    if (!missed_phrase_ids.empty() && onDeadlineMiss != nullptr)
+    {
+        for (const auto phrase_id : missed_phrase_ids)
+        {
+            onDeadlineMiss(phrase_id);
+        }
+    }
+
+    std::sort(candidates.begin(), candidates.end(),
+        [](const auto& lhs, const auto& rhs) { return lhs.distanceSeconds < rhs.distanceSeconds; });
+
+    // NOTE: Keep no more current jobs than threads, so that a seek re-prioritizes everything not started yet.
+    for (auto& candidate : candidates)
+    {
+        if (num_renders_in_flight >= renderThreadPool.getNumThreads())
+        {
+            break;
+        }
+
+        {
+            const juce::SpinLock::ScopedLockType lock(phraseLock);
+
+            const auto found = phrases.find(candidate.phraseId);
+            if (found == phrases.end() || found->second->generation != candidate.generation)
+            {
+                continue;
+            }
+
+            found->second->isRendering = true;
+        }
+
+        num_renders_in_flight++;
+
+        renderThreadPool.addJob([this, candidate] {
+            render(candidate.phraseId, candidate.generation, candidate.speakerId, candidate.decodeSource);
+        });
+    }
+}
+
+void VoicevoxRenderAheadEngine::render(int phrase_id, juce::int64 generation, juce::uint32 speaker_id, std::shared_ptr<const VoicevoxSfDecodeSource> decode_source)
+{
+    auto is_stale = false;
+
+    {
+        const juce::SpinLock::ScopedLockType lock(phraseLock);
+
+        const auto found = phrases.find(phrase_id);
+        is_stale = found == phrases.end() || found->second->generation != generation;
+    }
+
+    // NOTE: Invalidated while queued behind a stale render, skip the core call.
+    if (is_stale)
+    {
+        numRendersDiscarded++;
+        return;
+    }
+
+    VoicevoxThreadPlacement::applyInferenceAffinity();
+
+    auto result = voicevoxClient.singBySfDecode(speaker_id, *decode_source);
+
+    std::shared_ptr<const std::vector<float>> rendered_audio;
+    if (result.has_value())
+    {
+        rendered_audio = std::make_shared<const std::vector<float>>(std::move(*result));
+    }
+
+    auto is_accepted = false;
+
+    {
+        const juce::SpinLock::ScopedLockType lock(phraseLock);
+
+        const auto found = phrases.find(phrase_id);
+        if (found != phrases.end() && found->second->generation == generation)
+        {
+            auto& phrase = *found->second;
+            phrase.isRendering = false;
+            phrase.hasRenderFailed = rendered_audio == nullptr;
+            phrase.renderedAudio = rendered_audio;
+            is_accepted = true;
+
+            if (rendered_audio != nullptr)
+            {
+                publishRenderedAudio();
+            }
+        }
+    }
+
+    if (!is_accepted)
+    {
+        numRendersDiscarded++;
+    }
+    else if (rendered_audio == nullptr)
+    {
+        numRendersFailed++;
+    }
+    else
+    {
+        numRendersCompleted++;
+    }
+
+    scheduler->notify();
+}
+
+}
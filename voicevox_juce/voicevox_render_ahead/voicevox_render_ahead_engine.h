@@ -0,0 +1,124 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+namespace voicevox
+{
+
+class VoicevoxClient;
+struct VoicevoxSfDecodeSource;
+
+//==============================================================================
+struct VoicevoxRenderAheadOptions
+{
+    // Phrases starting within this horizon ahead of the playhead are kept rendered.
+    double lookAheadSeconds{ 8.0 };
+
+    // Phrases that ended within this horizon behind the playhead are kept as well.
+    double lookBehindSeconds{ 2.0 };
+
+    int numRenderThreads{ 1 };
+    int schedulerIntervalMilliseconds{ 10 };
+};
+
+//==============================================================================
+/**
+    Keeps song phrases rendered ahead of the host playhead.
+
+    The audio thread only publishes the transport with updateTransport() and
+    polls results with getRenderedAudio(), neither of them blocks or takes a
+    lock shared with the scheduler. Rendered audio is published as an
+    immutable snapshot which is swapped whenever a render lands or is evicted. A scheduler
+    thread renders the phrases inside the look-ahead horizon in order of their
+    distance from the playhead, discards renders that became useless after a
+    seek, and counts a deadline miss for every phrase that starts playing
+    before its audio is ready.
+
+    A phrase whose render failed is not retried until the phrase list or the
+    connection of the client changes.
+*/
+class VoicevoxRenderAheadEngine final
+{
+public:
+    //==============================================================================
+    struct Statistics
+    {
+        juce::uint64 numRendersCompleted{ 0 };
+        juce::uint64 numRendersDiscarded{ 0 };
+        juce::uint64 numRendersFailed{ 0 };
+        juce::uint64 numDeadlineMisses{ 0 };
+        juce::uint64 numSeeks{ 0 };
+    };
+
+    //==============================================================================
+    explicit VoicevoxRenderAheadEngine(VoicevoxClient& client, const VoicevoxRenderAheadOptions& options = {});
+    ~VoicevoxRenderAheadEngine();
+
+    //==============================================================================
+    // Replaces any previous phrase with the same id and invalidates its render.
+    void setPhrase(int phrase_id, double start_ppq, juce::uint32 speaker_id, const VoicevoxSfDecodeSource& decode_source);
+    void removePhrase(int phrase_id);
+    void clearPhrases();
+
+    //==============================================================================
+    // Real-time safe, call from the audio thread every block.
+    void updateTransport(double ppq_position, double bpm, bool is_playing) noexcept;
+
+    // Real-time safe, returns nullptr when the phrase is not rendered yet.
+    // NOTE: Do not hold the returned pointer longer than needed, the last release frees the buffer.
+    std::shared_ptr<const std::vector<float>> getRenderedAudio(int phrase_id) const noexcept;
+
+    //==============================================================================
+    Statistics getStatistics() const noexcept;
+
+    // Called from the scheduler thread, assign before the first updateTransport() call.
+    std::function<void(int phrase_id)> onDeadlineMiss;
+
+private:
+    //==============================================================================
+    struct Phrase;
+    class Scheduler;
+
+    // Sorted by phrase id.
+    using RenderedAudioSnapshot = std::vector<std::pair<int, std::shared_ptr<const std::vector<float>>>>;
+
+    void publishRenderedAudio();
+    void clearRenderFailures();
+    void schedule();
+    void render(int phrase_id, juce::int64 generation, juce::uint32 speaker_id, std::shared_ptr<const VoicevoxSfDecodeSource> decode_source);
+
+    //==============================================================================
+    VoicevoxClient& voicevoxClient;
+    const VoicevoxRenderAheadOptions options;
+
+    mutable juce::SpinLock phraseLock;
+    std::map<int, std::shared_ptr<Phrase>> phrases;
+    juce::int64 nextGeneration;
+
+    // NOTE: Read by the audio thread with std::atomic_load. The previous snapshot is kept alive until the next swap,
+    //       so that the audio thread doesn't free it by releasing the last reference.
+    std::shared_ptr<const RenderedAudioSnapshot> renderedAudioSnapshot;
+    std::shared_ptr<const RenderedAudioSnapshot> retiredRenderedAudioSnapshot;
+
+    std::atomic<double> transportPpq{ 0.0 };
+    std::atomic<double> transportBpm{ 120.0 };
+    std::atomic<bool> transportIsPlaying{ false };
+    std::atomic<juce::uint32> seekCounter{ 0 };
+    juce::uint32 lastSeekCounter;
+    bool lastIsConnected;
+
+    std::atomic<juce::uint64> numRendersCompleted{ 0 };
+    std::atomic<juce::uint64> numRendersDiscarded{ 0 };
+    std::atomic<juce::uint64> numRendersFailed{ 0 };
+    std::atomic<juce::uint64> numDeadlineMisses{ 0 };
+
+    juce::ThreadPool renderThreadPool;
+    std::unique_ptr<Scheduler> scheduler;
+
+    // Only touched by the audio thread.
+    double previousTransportPpq;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VoicevoxRenderAheadEngine)
+};
+
+}
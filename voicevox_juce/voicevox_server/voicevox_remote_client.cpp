@@ -0,0 +1,430 @@
+#include "voicevox_remote_client.h"
+#include "voicevox_server_protocol.h"
+#include "../voicevox_client/voicevox_client.h"
+#include "../voicevox_log/voicevox_event_log.h"
+
+namespace voicevox
+{
+
+//==============================================================================
+VoicevoxRemoteClient::VoicevoxRemoteClient(int port_to_use, int timeout_milliseconds, int response_timeout_milliseconds, int max_connections)
+    : port(port_to_use)
+    , timeoutMilliseconds(timeout_milliseconds)
+    , responseTimeoutMilliseconds(response_timeout_milliseconds)
+    , maxConnections(std::max(1, max_connections))
+    , numOpenSockets(0)
+    , poolGeneration(0)
+    , isConnected_(false)
+{
+}
+
+VoicevoxRemoteClient::~VoicevoxRemoteClient()
+{
+    disconnect();
+}
+
+//==============================================================================
+void VoicevoxRemoteClient::connect()
+{
+    disconnect();
+
+    // NOTE: The first connection is opened right away, so that an unreachable server is reported here.
+    auto socket = std::make_unique<juce::StreamingSocket>();
+
+    if (!socket->connect("127.0.0.1", port, timeoutMilliseconds))
+    {
+        VoicevoxEventLog::log(VoicevoxLogLevel::Warning, VoicevoxEventId::ServerUnreachable, 0, 0, 0, port);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(poolMutex);
+
+    idleSockets.push_back(std::move(socket));
+    numOpenSockets = 1;
+    isConnected_ = true;
+}
+
+void VoicevoxRemoteClient::disconnect()
+{
+    std::lock_guard<std::mutex> lock(poolMutex);
+
+    resetPool();
+    socketAvailable.notify_all();
+}
+
+bool VoicevoxRemoteClient::isConnected() const
+{
+    std::lock_guard<std::mutex> lock(poolMutex);
+
+    return isConnected_;
+}
+
+//==============================================================================
+// NOTE: Called with poolMutex held. Sockets in use are closed when they are released, see releaseSocket().
+void VoicevoxRemoteClient::resetPool() const
+{
+    for (auto& socket : idleSockets)
+    {
+        socket->close();
+    }
+
+    idleSockets.clear();
+    numOpenSockets = 0;
+    poolGeneration++;
+    isConnected_ = false;
+}
+
+std::unique_ptr<juce::StreamingSocket> VoicevoxRemoteClient::acquireSocket(juce::uint64& generation) const
+{
+    {
+        std::unique_lock<std::mutex> lock(poolMutex);
+
+        socketAvailable.wait(lock, [this] { return !isConnected_ || !idleSockets.empty() || numOpenSockets < maxConnections; });
+
+        if (!isConnected_)
+        {
+            return nullptr;
+        }
+
+        generation = poolGeneration;
+
+        if (!idleSockets.empty())
+        {
+            auto socket = std::move(idleSockets.back());
+            idleSockets.pop_back();
+            return socket;
+        }
+
+        numOpenSockets++;
+    }
+
+    // NOTE: Connected outside of the lock, other calls keep using the sockets already open meanwhile.
+    auto socket = std::make_unique<juce::StreamingSocket>();
+    if (socket->connect("127.0.0.1", port, timeoutMilliseconds))
+    {
+        return socket;
+    }
+
+    std::lock_guard<std::mutex> lock(poolMutex);
+
+    if (generation == poolGeneration)
+    {
+        numOpenSockets--;
+    }
+
+    socketAvailable.notify_one();
+    return nullptr;
+}
+
+void VoicevoxRemoteClient::releaseSocket(std::unique_ptr<juce::StreamingSocket> socket, juce::uint64 generation) const
+{
+    std::lock_guard<std::mutex> lock(poolMutex);
+
+    if (generation != poolGeneration)
+    {
+        socket->close();
+        return;
+    }
+
+    if (!socket->isConnected())
+    {
+        // NOTE: Same as with a single connection, a lost or stalled server disconnects the client.
+        resetPool();
+        socketAvailable.notify_all();
+        return;
+    }
+
+    idleSockets.push_back(std::move(socket));
+    socketAvailable.notify_one();
+}
+
+//==============================================================================
+juce::Result VoicevoxRemoteClient::call(VoicevoxServerMethod method, juce::uint32 speaker_id, const juce::MemoryBlock& payload, const BodyChunkCallback& on_chunk) const
+{
+    juce::uint64 generation = 0;
+
+    auto socket = acquireSocket(generation);
+    if (socket == nullptr)
+    {
+        return juce::Result::fail("Disconnected");
+    }
+
+    const auto result = call(*socket, method, speaker_id, payload, on_chunk);
+    releaseSocket(std::move(socket), generation);
+
+    return result;
+}
+
+juce::Result VoicevoxRemoteClient::call(juce::StreamingSocket& socket, VoicevoxServerMethod method, juce::uint32 speaker_id, const juce::MemoryBlock& payload, const BodyChunkCallback& on_chunk) const
+{
+    VoicevoxServerRequestHeader header;
+    header.method = method;
+    header.speakerId = speaker_id;
+
+    VoicevoxServerStatus status = VoicevoxServerStatus::Failed;
+
+    if (!VoicevoxServerProtocol::writeRequest(socket, header, payload))
+    {
+        // NOTE: The stream can't be resynchronized after a partial transfer, so drop the connection.
+        socket.close();
+        return juce::Result::fail("Connection lost");
+    }
+
+    if (!waitForResponseData(socket))
+    {
+        return juce::Result::fail("No response within " + juce::String(responseTimeoutMilliseconds) + " ms");
+    }
+
+    if (!VoicevoxServerProtocol::readResponseHeader(socket, status, responseTimeoutMilliseconds))
+    {
+        socket.close();
+        return juce::Result::fail("Connection lost");
+    }
+
+    juce::MemoryBlock error_body;
+    bool is_cancelled = false;
+
+    for (;;)
+    {
+        if (!waitForResponseData(socket))
+        {
+            return juce::Result::fail("No response within " + juce::String(responseTimeoutMilliseconds) + " ms");
+        }
+
+        juce::MemoryBlock chunk;
+        if (!VoicevoxServerProtocol::readResponseChunk(socket, chunk, responseTimeoutMilliseconds))
+        {
+            socket.close();
+            return juce::Result::fail("Connection lost");
+        }
+
+        if (chunk.getSize() == 0)
+        {
+            break;
+        }
+
+        if (status != VoicevoxServerStatus::Ok)
+        {
+            error_body.append(chunk.getData(), chunk.getSize());
+        }
+        else if (!is_cancelled)
+        {
+            // NOTE: Keep reading after a cancel, the connection has to stay in sync for the next call.
+            is_cancelled = !on_chunk(chunk);
+        }
+    }
+
+    if (status != VoicevoxServerStatus::Ok)
+    {
+        juce::MemoryInputStream stream(error_body, false);
+        return juce::Result::fail(stream.readString());
+    }
+
+    if (is_cancelled)
+    {
+        return juce::Result::fail("Cancelled");
+    }
+
+    return juce::Result::ok();
+}
+
+// NOTE: A stalled server is told apart from a lost connection here,
+//       the reads themselves time out as well in case the server stalls half way through a chunk.
+bool VoicevoxRemoteClient::waitForResponseData(juce::StreamingSocket& socket) const
+{
+    if (socket.waitUntilReady(true, responseTimeoutMilliseconds) == 0)
+    {
+        // NOTE: The late response would be read as the answer to the next call, so drop the connection.
+        socket.close();
+        return false;
+    }
+
+    return true;
+}
+
+std::optional<juce::MemoryBlock> VoicevoxRemoteClient::call(VoicevoxServerMethod method, juce::uint32 speaker_id, const juce::MemoryBlock& payload, juce::String* error_message) const
+{
+    juce::MemoryBlock body;
+
+    const auto result = call(method, speaker_id, payload, [&body](const juce::MemoryBlock& chunk) {
+        body.append(chunk.getData(), chunk.getSize());
+        return true;
+    });
+
+    if (result.failed())
+    {
+        if (error_message != nullptr)
+        {
+            *error_message = result.getErrorMessage();
+        }
+        return std::nullopt;
+    }
+
+    return body;
+}
+
+//==============================================================================
+juce::var VoicevoxRemoteClient::getMetasJson() const
+{
+    const auto body = call(VoicevoxServerMethod::GetMetasJson, 0, {});
+    if (!body.has_value())
+    {
+        return juce::var();
+    }
+
+    juce::MemoryInputStream stream(*body, false);
+    return juce::JSON::parse(stream.readString());
+}
+
+juce::Result VoicevoxRemoteClient::loadModel(juce::uint32 speaker_id)
+{
+    juce::String error_message;
+
+    if (!call(VoicevoxServerMethod::LoadModel, speaker_id, {}, &error_message).has_value())
+    {
+        return juce::Result::fail(error_message);
+    }
+
+    return juce::Result::ok();
+}
+
+bool VoicevoxRemoteClient::isModelLoaded(juce::uint32 speaker_id) const
+{
+    const auto body = call(VoicevoxServerMethod::IsModelLoaded, speaker_id, {});
+    if (!body.has_value())
+    {
+        return false;
+    }
+
+    juce::MemoryInputStream stream(*body, false);
+    return stream.readBool();
+}
+
+//==============================================================================
+double VoicevoxRemoteClient::getSampleRate() const
+{
+    const auto body = call(VoicevoxServerMethod::GetSampleRate, 0, {});
+    if (!body.has_value())
+    {
+        return 0.0;
+    }
+
+    juce::MemoryInputStream stream(*body, false);
+    return stream.readDouble();
+}
+
+std::int64_t VoicevoxRemoteClient::getSongTeacherSpeakerId() const
+{
+    return 6000;
+}
+
+//==============================================================================
+std::optional<std::vector<std::byte>> VoicevoxRemoteClient::synthesis(juce::uint32 speaker_id, const juce::String& audio_query_json)
+{
+    juce::MemoryOutputStream payload;
+    payload.writeString(audio_query_json);
+
+    const auto body = call(VoicevoxServerMethod::Synthesis, speaker_id, payload.getMemoryBlock());
+    if (!body.has_value())
+    {
+        return std::nullopt;
+    }
+
+    return VoicevoxServerProtocol::toVector<std::byte>(*body);
+}
+
+std::optional<std::vector<std::byte>> VoicevoxRemoteClient::tts(juce::uint32 speaker_id, const juce::String& speak_words)
+{
+    juce::MemoryOutputStream payload;
+    payload.writeString(speak_words);
+
+    const auto body = call(VoicevoxServerMethod::Tts, speaker_id, payload.getMemoryBlock());
+    if (!body.has_value())
+    {
+        return std::nullopt;
+    }
+
+    return VoicevoxServerProtocol::toVector<std::byte>(*body);
+}
+
+std::optional<std::vector<std::int64_t>> VoicevoxRemoteClient::predictSingConsonantLength(juce::uint32 speaker_id, const std::vector<std::int64_t>& note_consonant_vector, const std::vector<std::int64_t>& note_vowel_vector, const std::vector<std::int64_t>& note_length_vector)
+{
+    juce::MemoryOutputStream payload;
+    VoicevoxServerProtocol::writeVector(payload, note_consonant_vector);
+    VoicevoxServerProtocol::writeVector(payload, note_vowel_vector);
+    VoicevoxServerProtocol::writeVector(payload, note_length_vector);
+
+    const auto body = call(VoicevoxServerMethod::PredictSingConsonantLength, speaker_id, payload.getMemoryBlock());
+    if (!body.has_value())
+    {
+        return std::nullopt;
+    }
+
+    return VoicevoxServerProtocol::toVector<std::int64_t>(*body);
+}
+
+std::optional<std::vector<float>> VoicevoxRemoteClient::predictSingF0(juce::uint32 speaker_id, const std::vector<std::int64_t>& phoneme_flatten, const std::vector<std::int64_t>& note_vector)
+{
+    juce::MemoryOutputStream payload;
+    VoicevoxServerProtocol::writeVector(payload, phoneme_flatten);
+    VoicevoxServerProtocol::writeVector(payload, note_vector);
+
+    const auto body = call(VoicevoxServerMethod::PredictSingF0, speaker_id, payload.getMemoryBlock());
+    if (!body.has_value())
+    {
+        return std::nullopt;
+    }
+
+    return VoicevoxServerProtocol::toVector<float>(*body);
+}
+
+std::optional<std::vector<float>> VoicevoxRemoteClient::predictSingVolume(juce::uint32 speaker_id, const std::vector<std::int64_t>& phoneme, const std::vector<std::int64_t>& note, const std::vector<float>& f0)
+{
+    juce::MemoryOutputStream payload;
+    VoicevoxServerProtocol::writeVector(payload, phoneme);
+    VoicevoxServerProtocol::writeVector(payload, note);
+    VoicevoxServerProtocol::writeVector(payload, f0);
+
+    const auto body = call(VoicevoxServerMethod::PredictSingVolume, speaker_id, payload.getMemoryBlock());
+    if (!body.has_value())
+    {
+        return std::nullopt;
+    }
+
+    return VoicevoxServerProtocol::toVector<float>(*body);
+}
+
+std::optional<std::vector<float>> VoicevoxRemoteClient::singBySfDecode(juce::uint32 speaker_id, const VoicevoxSfDecodeSource& decode_source)
+{
+    juce::MemoryOutputStream payload;
+    VoicevoxServerProtocol::writeVector(payload, decode_source.phonemeVector);
+    VoicevoxServerProtocol::writeVector(payload, decode_source.f0Vector);
+    VoicevoxServerProtocol::writeVector(payload, decode_source.volumeVector);
+
+    const auto body = call(VoicevoxServerMethod::SingBySfDecode, speaker_id, payload.getMemoryBlock());
+    if (!body.has_value())
+    {
+        return std::nullopt;
+    }
+
+    return VoicevoxServerProtocol::toVector<float>(*body);
+}
+
+//==============================================================================
+juce::Result VoicevoxRemoteClient::singBySfDecodeStreaming(juce::uint32 speaker_id, const VoicevoxSfDecodeSource& decode_source, const SampleChunkCallback& on_samples, size_t chunk_frames, size_t context_frames)
+{
+    jassert(chunk_frames > 0);
+
+    juce::MemoryOutputStream payload;
+    VoicevoxServerProtocol::writeVector(payload, decode_source.phonemeVector);
+    VoicevoxServerProtocol::writeVector(payload, decode_source.f0Vector);
+    VoicevoxServerProtocol::writeVector(payload, decode_source.volumeVector);
+    payload.writeInt64((juce::int64)chunk_frames);
+    payload.writeInt64((juce::int64)context_frames);
+
+    // NOTE: The server sends every decoded chunk as one body chunk, so each one holds whole samples.
+    return call(VoicevoxServerMethod::SingBySfDecodeStreaming, speaker_id, payload.getMemoryBlock(),
+                [&on_samples](const juce::MemoryBlock& chunk) { return on_samples(static_cast<const float*>(chunk.getData()), chunk.getSize() / sizeof(float)); });
+}
+
+}
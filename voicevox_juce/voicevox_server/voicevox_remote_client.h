@@ -0,0 +1,97 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <condition_variable>
+#include "../voicevox_log/voicevox_event_log.h"
+
+namespace voicevox
+{
+
+struct VoicevoxSfDecodeSource;
+enum class VoicevoxServerMethod : juce::uint32;
+
+//==============================================================================
+/**
+    Thin client of VoicevoxServer.
+
+    Exposes the same methods as VoicevoxClient, so that a process can switch
+    from an embedded core to a shared server without touching the call sites.
+
+    Every call holds one connection for its request and response. Calls from
+    several threads run on their own connections, opened on demand up to
+    max_connections, so they overlap and the server can batch them. A lost or
+    stalled connection disconnects the client until connect() is called again.
+*/
+class VoicevoxRemoteClient final
+{
+public:
+    //==============================================================================
+    // timeout_milliseconds bounds connecting, response_timeout_milliseconds bounds every wait for response data,
+    // so that a stalled or dead server fails the call instead of hanging it.
+    explicit VoicevoxRemoteClient(int port = 50121, int timeout_milliseconds = 3000, int response_timeout_milliseconds = 60000, int max_connections = 4);
+    ~VoicevoxRemoteClient();
+
+    //==============================================================================
+    void connect();
+    void disconnect();
+    bool isConnected() const;
+
+    //==============================================================================
+    juce::var getMetasJson() const;
+    juce::Result loadModel(juce::uint32 speaker_id);
+    bool isModelLoaded(juce::uint32 speaker_id) const;
+
+    //==============================================================================
+    double getSampleRate() const;
+    std::int64_t getSongTeacherSpeakerId() const;
+
+    //==============================================================================
+    // High level API
+    std::optional<std::vector<std::byte>> synthesis(juce::uint32 speaker_id, const juce::String& audio_query_json);
+    std::optional<std::vector<std::byte>> tts(juce::uint32 speaker_id, const juce::String& speak_words);
+
+    //==============================================================================
+    // Song API
+    std::optional<std::vector<std::int64_t>> predictSingConsonantLength(juce::uint32 speaker_id, const std::vector<std::int64_t>& note_consonant_vector, const std::vector<std::int64_t>& note_vowel_vector, const std::vector<std::int64_t>& note_length_vector);
+    std::optional<std::vector<float>> predictSingF0(juce::uint32 speaker_id, const std::vector<std::int64_t>& phoneme_flatten, const std::vector<std::int64_t>& note_vector);
+    std::optional<std::vector<float>> predictSingVolume(juce::uint32 speaker_id, const std::vector<std::int64_t>& phoneme, const std::vector<std::int64_t>& note, const std::vector<float>& f0);
+    std::optional<std::vector<float>> singBySfDecode(juce::uint32 speaker_id, const VoicevoxSfDecodeSource& decode_source);
+
+    //==============================================================================
+    // Song API decoding chunk by chunk on the server, every chunk of samples is handed to the callback as soon as it arrives.
+    // Return false from the callback to cancel, the rest of the response is then read and dropped.
+    using SampleChunkCallback = std::function<bool(const float* samples, size_t num_samples)>;
+    juce::Result singBySfDecodeStreaming(juce::uint32 speaker_id, const VoicevoxSfDecodeSource& decode_source, const SampleChunkCallback& on_samples, size_t chunk_frames = 256, size_t context_frames = 32);
+
+private:
+    //==============================================================================
+    using BodyChunkCallback = std::function<bool(const juce::MemoryBlock& chunk)>;
+    juce::Result call(VoicevoxServerMethod method, juce::uint32 speaker_id, const juce::MemoryBlock& payload, const BodyChunkCallback& on_chunk) const;
+    juce::Result call(juce::StreamingSocket& socket, VoicevoxServerMethod method, juce::uint32 speaker_id, const juce::MemoryBlock& payload, const BodyChunkCallback& on_chunk) const;
+    std::optional<juce::MemoryBlock> call(VoicevoxServerMethod method, juce::uint32 speaker_id, const juce::MemoryBlock& payload, juce::String* error_message = nullptr) const;
+    bool waitForResponseData(juce::StreamingSocket& socket) const;
+
+    std::unique_ptr<juce::StreamingSocket> acquireSocket(juce::uint64& generation) const;
+    void releaseSocket(std::unique_ptr<juce::StreamingSocket> socket, juce::uint64 generation) const;
+    void resetPool() const;
+
+    //==============================================================================
+    SharedVoicevoxEventLogDrain sharedEventLogDrain;
+
+    const int port;
+    const int timeoutMilliseconds;
+    const int responseTimeoutMilliseconds;
+    const int maxConnections;
+
+    // NOTE: Sockets released after a disconnect() belong to an older generation and are closed instead of pooled.
+    mutable std::mutex poolMutex;
+    mutable std::condition_variable socketAvailable;
+    mutable std::vector<std::unique_ptr<juce::StreamingSocket>> idleSockets;
+    mutable int numOpenSockets;
+    mutable juce::uint64 poolGeneration;
+    mutable bool isConnected_;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VoicevoxRemoteClient)
+};
+
+}
@@ -0,0 +1,884 @@
+#include "voicevox_server.h"
+#include "voicevox_server_protocol.h"
+#include "../voicevox_client/voicevox_client.h"
+#include "../voicevox_batch/voicevox_phrase_batcher.h"
+#include "../voicevox_log/voicevox_event_log.h"
+#include "../voicevox_threading/voicevox_thread_placement.h"
+
+#include <deque>
+#include <condition_variable>
+
+namespace voicevox
+{
+
+//==============================================================================
+struct VoicevoxServerResponse
+{
+    VoicevoxServerStatus status{ VoicevoxServerStatus::Failed };
+    juce::MemoryBlock body{};
+};
+
+class VoicevoxServerPendingRequest final
+{
+public:
+    VoicevoxServerPendingRequest(const VoicevoxServerRequestHeader& header_to_use, juce::MemoryBlock&& payload_to_use)
+        : header(header_to_use)
+        , payload(std::move(payload_to_use))
+        , arrivalTime(std::chrono::steady_clock::now())
+    {
+    }
+
+    // Only the first response counts, a request failed by stop() may still be answered by a running worker.
+    void respond(VoicevoxServerResponse&& response_to_send)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (response.has_value())
+            {
+                return;
+            }
+
+            response = std::move(response_to_send);
+        }
+
+        condition.notify_all();
+    }
+
+    // Hands a piece of a streamed body to the connection, returns false once the connection gave up on the request.
+    bool pushChunk(juce::MemoryBlock&& chunk)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (isAbandoned)
+            {
+                return false;
+            }
+
+            chunks.push_back(std::move(chunk));
+        }
+
+        condition.notify_all();
+        return true;
+    }
+
+    void abandon()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        isAbandoned = true;
+        chunks.clear();
+    }
+
+    // Takes the chunks pushed so far, returns true once the response is there as well.
+    bool waitForResponse(VoicevoxServerResponse& response_to_receive, std::deque<juce::MemoryBlock>& chunks_to_receive, int timeout_milliseconds)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait_for(lock, std::chrono::milliseconds(timeout_milliseconds), [this] { return response.has_value() || !chunks.empty(); });
+
+        chunks_to_receive.swap(chunks);
+        chunks.clear();
+
+        if (!response.has_value())
+        {
+            return false;
+        }
+
+        response_to_receive = std::move(*response);
+        return true;
+    }
+
+    const VoicevoxServerRequestHeader header;
+    const juce::MemoryBlock payload;
+    const std::chrono::steady_clock::time_point arrivalTime;
+
+private:
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::optional<VoicevoxServerResponse> response;
+    std::deque<juce::MemoryBlock> chunks;
+    bool isAbandoned{ false };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VoicevoxServerPendingRequest)
+};
+
+using VoicevoxServerRequestBatch = std::vector<std::shared_ptr<VoicevoxServerPendingRequest>>;
+
+namespace
+{
+    VoicevoxServerResponse makeFailedResponse(VoicevoxServerStatus status, const juce::String& message = {})
+    {
+        juce::MemoryOutputStream body;
+        body.writeString(message);
+
+        return { status, body.getMemoryBlock() };
+    }
+
+    template <typename ElementType>
+    VoicevoxServerResponse makeVectorResponse(const std::optional<std::vector<ElementType>>& result)
+    {
+        if (!result.has_value())
+        {
+            return makeFailedResponse(VoicevoxServerStatus::Failed);
+        }
+
+        return { VoicevoxServerStatus::Ok, juce::MemoryBlock(result->data(), result->size() * sizeof(ElementType)) };
+    }
+
+    VoicevoxServerResponse executeRequest(VoicevoxClient& client, VoicevoxServerPendingRequest& request)
+    {
+        if (!client.isConnected())
+        {
+            return makeFailedResponse(VoicevoxServerStatus::Disconnected, "Disconnected");
+        }
+
+        juce::MemoryInputStream stream(request.payload, false);
+        juce::MemoryOutputStream body;
+        const auto speaker_id = request.header.speakerId;
+
+        switch (request.header.method)
+        {
+        case VoicevoxServerMethod::GetMetasJson:
+            body.writeString(juce::JSON::toString(client.getMetasJson(), true));
+            break;
+
+        case VoicevoxServerMethod::LoadModel:
+        {
+            const auto result = client.loadModel(speaker_id);
+            if (result.failed())
+            {
+                return makeFailedResponse(VoicevoxServerStatus::Failed, result.getErrorMessage());
+            }
+            break;
+        }
+
+        case VoicevoxServerMethod::IsModelLoaded:
+            body.writeBool(client.isModelLoaded(speaker_id));
+            break;
+
+        case VoicevoxServerMethod::GetSampleRate:
+            body.writeDouble(client.getSampleRate());
+            break;
+
+        case VoicevoxServerMethod::Synthesis:
+            return makeVectorResponse(client.synthesis(speaker_id, stream.readString()));
+
+        case VoicevoxServerMethod::Tts:
+            return makeVectorResponse(client.tts(speaker_id, stream.readString()));
+
+        case VoicevoxServerMethod::PredictSingConsonantLength:
+        {
+            const auto consonant = VoicevoxServerProtocol::readVector<std::int64_t>(stream);
+            const auto vowel = VoicevoxServerProtocol::readVector<std::int64_t>(stream);
+            const auto note_length = VoicevoxServerProtocol::readVector<std::int64_t>(stream);
+            if (!consonant.has_value() || !vowel.has_value() || !note_length.has_value()
+                || vowel->size() != consonant->size() || note_length->size() != consonant->size())
+            {
+                return makeFailedResponse(VoicevoxServerStatus::BadRequest);
+            }
+
+            return makeVectorResponse(client.predictSingConsonantLength(speaker_id, *consonant, *vowel, *note_length));
+        }
+
+        case VoicevoxServerMethod::PredictSingF0:
+        {
+            const auto phoneme = VoicevoxServerProtocol::readVector<std::int64_t>(stream);
+            const auto note = VoicevoxServerProtocol::readVector<std::int64_t>(stream);
+            if (!phoneme.has_value() || !note.has_value() || note->size() != phoneme->size())
+            {
+                return makeFailedResponse(VoicevoxServerStatus::BadRequest);
+            }
+
+            return makeVectorResponse(client.predictSingF0(speaker_id, *phoneme, *note));
+        }
+
+        case VoicevoxServerMethod::PredictSingVolume:
+        {
+            const auto phoneme = VoicevoxServerProtocol::readVector<std::int64_t>(stream);
+            const auto note = VoicevoxServerProtocol::readVector<std::int64_t>(stream);
+            const auto f0 = VoicevoxServerProtocol::readVector<float>(stream);
+            if (!phoneme.has_value() || !note.has_value() || !f0.has_value()
+                || note->size() != phoneme->size() || f0->size() != phoneme->size())
+            {
+                return makeFailedResponse(VoicevoxServerStatus::BadRequest);
+            }
+
+            return makeVectorResponse(client.predictSingVolume(speaker_id, *phoneme, *note, *f0));
+        }
+
+        case VoicevoxServerMethod::SingBySfDecode:
+        {
+            VoicevoxSfDecodeSource decode_source;
+
+            auto phoneme = VoicevoxServerProtocol::readVector<std::int64_t>(stream);
+            auto f0 = VoicevoxServerProtocol::readVector<float>(stream);
+            auto volume = VoicevoxServerProtocol::readVector<float>(stream);
+            if (!phoneme.has_value() || !f0.has_value() || !volume.has_value()
+                || phoneme->size() != f0->size() || volume->size() != f0->size())
+            {
+                return makeFailedResponse(VoicevoxServerStatus::BadRequest);
+            }
+
+            decode_source.phonemeVector = std::move(*phoneme);
+            decode_source.f0Vector = std::move(*f0);
+            decode_source.volumeVector = std::move(*volume);
+
+            return makeVectorResponse(client.singBySfDecode(speaker_id, decode_source));
+        }
+
+        case VoicevoxServerMethod::SingBySfDecodeStreaming:
+        {
+            VoicevoxSfDecodeSource decode_source;
+
+            auto phoneme = VoicevoxServerProtocol::readVector<std::int64_t>(stream);
+            auto f0 = VoicevoxServerProtocol::readVector<float>(stream);
+            auto volume = VoicevoxServerProtocol::readVector<float>(stream);
+            const auto chunk_frames = stream.readInt64();
+            const auto context_frames = stream.readInt64();
+            if (!phoneme.has_value() || !f0.has_value() || !volume.has_value()
+                || phoneme->size() != f0->size() || volume->size() != f0->size()
+                || chunk_frames <= 0 || context_frames < 0)
+            {
+                return makeFailedResponse(VoicevoxServerStatus::BadRequest);
+            }
+
+            decode_source.phonemeVector = std::move(*phoneme);
+            decode_source.f0Vector = std::move(*f0);
+            decode_source.volumeVector = std::move(*volume);
+
+            // NOTE: Each chunk goes to the connection as soon as it is decoded, the response only closes the stream.
+            const auto result = client.singBySfDecodeStreaming(speaker_id, decode_source,
+                [&request](const float* samples, size_t num_samples) { return request.pushChunk(juce::MemoryBlock(samples, num_samples * sizeof(float))); },
+                (size_t)chunk_frames, (size_t)context_frames);
+
+            if (result.failed())
+            {
+                return makeFailedResponse(VoicevoxServerStatus::Failed, result.getErrorMessage());
+            }
+            break;
+        }
+
+        default:
+            return makeFailedResponse(VoicevoxServerStatus::BadRequest, "Unknown method");
+        }
+
+        return { VoicevoxServerStatus::Ok, body.getMemoryBlock() };
+    }
+
+    //==============================================================================
+    bool isCoalescableSongStage(VoicevoxServerMethod method)
+    {
+        return method == VoicevoxServerMethod::PredictSingF0
+            || method == VoicevoxServerMethod::PredictSingVolume
+            || method == VoicevoxServerMethod::SingBySfDecode;
+    }
+
+    bool isSameSongStageBatch(const VoicevoxServerRequestHeader& lhs, const VoicevoxServerRequestHeader& rhs)
+    {
+        return lhs.method == rhs.method && lhs.speakerId == rhs.speakerId;
+    }
+
+    // Parses every request of the batch, requests with a malformed payload are answered right away and dropped from the batch.
+    template <typename InputType>
+    std::vector<InputType> readSongStageInputs(VoicevoxServerRequestBatch& batch, const std::function<std::optional<InputType>(juce::MemoryInputStream&)>& read_input)
+    {
+        std::vector<InputType> inputs;
+        VoicevoxServerRequestBatch valid_requests;
+
+        for (auto& request : batch)
+        {
+            juce::MemoryInputStream stream(request->payload, false);
+
+            auto input = read_input(stream);
+            if (!input.has_value())
+            {
+                request->respond(makeFailedResponse(VoicevoxServerStatus::BadRequest));
+                continue;
+            }
+
+            inputs.push_back(std::move(*input));
+            valid_requests.push_back(std::move(request));
+        }
+
+        batch = std::move(valid_requests);
+        return inputs;
+    }
+
+    std::optional<VoicevoxBatchPhrase> readSongStagePhrase(juce::MemoryInputStream& stream)
+    {
+        auto phoneme = VoicevoxServerProtocol::readVector<std::int64_t>(stream);
+        auto note = VoicevoxServerProtocol::readVector<std::int64_t>(stream);
+        if (!phoneme.has_value() || !note.has_value() || phoneme->size() != note->size())
+        {
+            return std::nullopt;
+        }
+
+        VoicevoxBatchPhrase phrase;
+        phrase.phonemeVector = std::move(*phoneme);
+        phrase.noteVector = std::move(*note);
+
+        return phrase;
+    }
+
+    // Runs one song stage for every request of the batch with as few core calls as possible.
+    void executeSongStageBatch(VoicevoxClient& client, VoicevoxPhraseBatcher& phrase_batcher, VoicevoxServerRequestBatch& batch)
+    {
+        const auto header = batch.front()->header;
+
+        std::optional<std::vector<std::vector<float>>> outputs;
+
+        switch (header.method)
+        {
+        case VoicevoxServerMethod::PredictSingF0:
+        {
+            const auto phrases = readSongStageInputs<VoicevoxBatchPhrase>(batch, readSongStagePhrase);
+            outputs = phrase_batcher.predictF0(header.speakerId, phrases);
+            break;
+        }
+
+        case VoicevoxServerMethod::PredictSingVolume:
+        {
+            using PhraseWithF0 = std::pair<VoicevoxBatchPhrase, std::vector<float>>;
+
+            const auto inputs = readSongStageInputs<PhraseWithF0>(batch, [](juce::MemoryInputStream& stream) -> std::optional<PhraseWithF0> {
+                auto phrase = readSongStagePhrase(stream);
+                auto f0 = VoicevoxServerProtocol::readVector<float>(stream);
+                if (!phrase.has_value() || !f0.has_value() || f0->size() != phrase->phonemeVector.size())
+                {
+                    return std::nullopt;
+                }
+
+                return PhraseWithF0{ std::move(*phrase), std::move(*f0) };
+            });
+
+            std::vector<VoicevoxBatchPhrase> phrases;
+            std::vector<std::vector<float>> f0_vectors;
+            for (const auto& input : inputs)
+            {
+                phrases.push_back(input.first);
+                f0_vectors.push_back(input.second);
+            }
+
+            outputs = phrase_batcher.predictVolume(header.speakerId, phrases, f0_vectors);
+            break;
+        }
+
+        case VoicevoxServerMethod::SingBySfDecode:
+        {
+            const auto decode_sources = readSongStageInputs<VoicevoxSfDecodeSource>(batch, [](juce::MemoryInputStream& stream) -> std::optional<VoicevoxSfDecodeSource> {
+                auto phoneme = VoicevoxServerProtocol::readVector<std::int64_t>(stream);
+                auto f0 = VoicevoxServerProtocol::readVector<float>(stream);
+                auto volume = VoicevoxServerProtocol::readVector<float>(stream);
+                if (!phoneme.has_value() || !f0.has_value() || !volume.has_value()
+                    || phoneme->size() != f0->size() || volume->size() != f0->size())
+                {
+                    return std::nullopt;
+                }
+
+                VoicevoxSfDecodeSource decode_source;
+                decode_source.phonemeVector = std::move(*phoneme);
+                decode_source.f0Vector = std::move(*f0);
+                decode_source.volumeVector = std::move(*volume);
+
+                return decode_source;
+            });
+
+            outputs = phrase_batcher.decode(header.speakerId, decode_sources);
+            break;
+        }
+
+        default:
+            jassertfalse;
+            break;
+        }
+
+        if (!outputs.has_value())
+        {
+            // NOTE: Run them one by one, so that only the request which made the core fail gets the error.
+            for (auto& request : batch)
+            {
+                request->respond(executeRequest(client, *request));
+            }
+            return;
+        }
+
+        for (size_t index = 0; index < batch.size(); index++)
+        {
+            batch[index]->respond(makeVectorResponse(std::optional<std::vector<float>>(std::move((*outputs)[index]))));
+        }
+    }
+}
+
+//==============================================================================
+class VoicevoxServerDispatcher final
+{
+public:
+    VoicevoxServerDispatcher(VoicevoxClient& client, const VoicevoxServerOptions& options)
+        : batchWindow(std::max(0, options.batchWindowMilliseconds))
+        , maxBatchSize((size_t)std::max(1, options.maxBatchSize))
+        , isStopping(false)
+    {
+        for (int index = 0; index < std::max(1, options.numWorkerThreads); index++)
+        {
+            workers.add(new Worker(*this, client));
+        }
+    }
+
+    ~VoicevoxServerDispatcher()
+    {
+        cancelPendingRequests();
+
+        // NOTE: Calls already inside the core can't be interrupted, the workers are joined once they return.
+        workers.clear();
+    }
+
+    std::shared_ptr<VoicevoxServerPendingRequest> submit(const VoicevoxServerRequestHeader& header, juce::MemoryBlock&& payload)
+    {
+        auto request = std::make_shared<VoicevoxServerPendingRequest>(header, std::move(payload));
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            if (isStopping)
+            {
+                request->respond(makeFailedResponse(VoicevoxServerStatus::Disconnected, "Server stopped"));
+                return request;
+            }
+
+            if (canCoalesce(header))
+            {
+                for (auto& open_batch : openBatches)
+                {
+                    if (open_batch->size() < maxBatchSize && isSameSongStageBatch(open_batch->front()->header, header))
+                    {
+                        open_batch->push_back(request);
+                        condition.notify_all();
+                        return request;
+                    }
+                }
+            }
+
+            pendingRequests.push_back(request);
+        }
+
+        condition.notify_all();
+
+        return request;
+    }
+
+    // Fails every request which has not reached a worker yet with a disconnected status.
+    void cancelPendingRequests()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            isStopping = true;
+
+            for (auto& request : pendingRequests)
+            {
+                request->respond(makeFailedResponse(VoicevoxServerStatus::Disconnected, "Server stopped"));
+            }
+            pendingRequests.clear();
+
+            for (auto& open_batch : openBatches)
+            {
+                for (auto& request : *open_batch)
+                {
+                    request->respond(makeFailedResponse(VoicevoxServerStatus::Disconnected, "Server stopped"));
+                }
+            }
+        }
+
+        condition.notify_all();
+    }
+
+private:
+    //==============================================================================
+    class Worker final
+        : private juce::Thread
+    {
+    public:
+        Worker(VoicevoxServerDispatcher& owner_to_use, VoicevoxClient& client)
+            : juce::Thread("voicevox_server_worker")
+            , owner(owner_to_use)
+            , voicevoxClient(client)
+            , phraseBatcher(client)
+        {
+            startThread();
+        }
+
+        ~Worker() override
+        {
+            signalThreadShouldExit();
+            owner.condition.notify_all();
+            stopThread(-1);
+        }
+
+    private:
+        void run() override
+        {
+            // NOTE: Workers call into the core, the connection threads only move bytes.
+            VoicevoxThreadPlacement::applyInferenceAffinity();
+
+            while (!threadShouldExit())
+            {
+                auto batch = owner.waitForNextBatch(*this);
+
+                if (batch.size() == 1)
+                {
+                    auto& request = *batch.front();
+                    request.respond(executeRequest(voicevoxClient, request));
+                }
+                else if (batch.size() > 1)
+                {
+                    executeSongStageBatch(voicevoxClient, phraseBatcher, batch);
+                }
+            }
+        }
+
+        VoicevoxServerDispatcher& owner;
+        VoicevoxClient& voicevoxClient;
+
+        // NOTE: One batcher per worker, it owns a frame arena which is reset on every call.
+        VoicevoxPhraseBatcher phraseBatcher;
+    };
+
+    //==============================================================================
+    bool canCoalesce(const VoicevoxServerRequestHeader& header) const
+    {
+        return batchWindow.count() > 0 && maxBatchSize > 1 && isCoalescableSongStage(header.method);
+    }
+
+    // Returns an empty batch when nothing arrived within the poll interval or the server is stopping.
+    VoicevoxServerRequestBatch waitForNextBatch(const juce::Thread& worker)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        condition.wait_for(lock, std::chrono::milliseconds(100), [this, &worker] { return !pendingRequests.empty() || isStopping || worker.threadShouldExit(); });
+        if (pendingRequests.empty() || isStopping)
+        {
+            return {};
+        }
+
+        auto batch = std::make_shared<VoicevoxServerRequestBatch>();
+        batch->push_back(std::move(pendingRequests.front()));
+        pendingRequests.pop_front();
+
+        const auto& first_request = *batch->front();
+        if (!canCoalesce(first_request.header))
+        {
+            return std::move(*batch);
+        }
+
+        // NOTE: Requests which queued up while every worker was busy join right away.
+        for (auto it = pendingRequests.begin(); it != pendingRequests.end() && batch->size() < maxBatchSize;)
+        {
+            if (isSameSongStageBatch((*it)->header, first_request.header))
+            {
+                batch->push_back(std::move(*it));
+                it = pendingRequests.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        // NOTE: The window counts from the arrival of the first request, so it only adds latency while the server is idle.
+        const auto deadline = first_request.arrivalTime + batchWindow;
+
+        if (batch->size() < maxBatchSize && std::chrono::steady_clock::now() < deadline)
+        {
+            openBatches.push_back(batch);
+            condition.wait_until(lock, deadline, [this, &batch] { return batch->size() >= maxBatchSize || isStopping; });
+            openBatches.erase(std::find(openBatches.begin(), openBatches.end(), batch));
+        }
+
+        if (isStopping)
+        {
+            return {};
+        }
+
+        return std::move(*batch);
+    }
+
+    //==============================================================================
+    const std::chrono::milliseconds batchWindow;
+    const size_t maxBatchSize;
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<std::shared_ptr<VoicevoxServerPendingRequest>> pendingRequests;
+    std::vector<std::shared_ptr<VoicevoxServerRequestBatch>> openBatches;
+    bool isStopping;
+
+    juce::OwnedArray<Worker> workers;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VoicevoxServerDispatcher)
+};
+
+//==============================================================================
+class VoicevoxServerConnection final
+    : public juce::Thread
+{
+public:
+    VoicevoxServerConnection(std::unique_ptr<juce::StreamingSocket> socket_to_use, VoicevoxServerDispatcher& dispatcher_to_use, size_t chunk_size)
+        : juce::Thread("voicevox_server_connection")
+        , socket(std::move(socket_to_use))
+        , dispatcher(dispatcher_to_use)
+        , responseChunkBytes(std::max<size_t>(1, chunk_size))
+    {
+        startThread();
+    }
+
+    ~VoicevoxServerConnection() override
+    {
+        signalThreadShouldExit();
+        socket->close();
+        stopThread(10000);
+    }
+
+private:
+    void run() override
+    {
+        VoicevoxThreadPlacement::applyWorkerAffinity();
+
+        while (!threadShouldExit() && socket->isConnected())
+        {
+            const auto ready = socket->waitUntilReady(true, 100);
+            if (ready < 0)
+            {
+                break;
+            }
+            if (ready == 0)
+            {
+                continue;
+            }
+
+            VoicevoxServerRequestHeader header;
+            if (!VoicevoxServerProtocol::readRequestHeader(*socket, header))
+            {
+                break;
+            }
+
+            juce::MemoryBlock payload(header.payloadSize);
+            if (!VoicevoxServerProtocol::readExactly(*socket, payload.getData(), payload.getSize()))
+            {
+                break;
+            }
+
+            const auto request = dispatcher.submit(header, std::move(payload));
+
+            if (!sendResponse(*request))
+            {
+                request->abandon();
+                break;
+            }
+        }
+
+        socket->close();
+    }
+
+    bool sendResponse(VoicevoxServerPendingRequest& request)
+    {
+        VoicevoxServerResponse response;
+        bool has_started_stream = false;
+
+        for (;;)
+        {
+            // NOTE: Poll, so that stop() never has to wait for an inference to finish.
+            std::deque<juce::MemoryBlock> chunks;
+            const auto has_response = request.waitForResponse(response, chunks, 100);
+
+            for (const auto& chunk : chunks)
+            {
+                if (!has_started_stream)
+                {
+                    if (!VoicevoxServerProtocol::writeResponseHeader(*socket, VoicevoxServerStatus::Ok))
+                    {
+                        return false;
+                    }
+
+                    has_started_stream = true;
+                }
+
+                if (!VoicevoxServerProtocol::writeResponseChunk(*socket, chunk.getData(), chunk.getSize()))
+                {
+                    return false;
+                }
+            }
+
+            if (has_response)
+            {
+                break;
+            }
+
+            if (threadShouldExit())
+            {
+                return false;
+            }
+        }
+
+        if (!has_started_stream)
+        {
+            return VoicevoxServerProtocol::writeResponse(*socket, response.status, response.body, responseChunkBytes);
+        }
+
+        // NOTE: The Ok status went out with the first chunk, a stream which failed later can only be ended by dropping the connection.
+        if (response.status != VoicevoxServerStatus::Ok)
+        {
+            return false;
+        }
+
+        return VoicevoxServerProtocol::writeResponseEnd(*socket);
+    }
+
+    std::unique_ptr<juce::StreamingSocket> socket;
+    VoicevoxServerDispatcher& dispatcher;
+    const size_t responseChunkBytes;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VoicevoxServerConnection)
+};
+
+//==============================================================================
+class VoicevoxServerListener final
+    : private juce::Thread
+{
+public:
+    VoicevoxServerListener(VoicevoxServerDispatcher& dispatcher_to_use, size_t chunk_size)
+        : juce::Thread("voicevox_server_listener")
+        , dispatcher(dispatcher_to_use)
+        , responseChunkBytes(chunk_size)
+    {
+    }
+
+    ~VoicevoxServerListener() override
+    {
+        signalThreadShouldExit();
+        listenerSocket.close();
+        stopThread(10000);
+
+        connections.clear();
+    }
+
+    bool listen(int port)
+    {
+        // NOTE: Bind to loopback only, this server is not meant to be reachable from other machines.
+        if (!listenerSocket.createListener(port, "127.0.0.1"))
+        {
+            return false;
+        }
+
+        startThread();
+        return true;
+    }
+
+    int getPort() const
+    {
+        return listenerSocket.getBoundPort();
+    }
+
+private:
+    void run() override
+    {
+        VoicevoxThreadPlacement::applyWorkerAffinity();
+
+        while (!threadShouldExit())
+        {
+            std::unique_ptr<juce::StreamingSocket> socket(listenerSocket.waitForNextConnection());
+
+            removeFinishedConnections();
+
+            if (socket == nullptr)
+            {
+                continue;
+            }
+
+            connections.add(new VoicevoxServerConnection(std::move(socket), dispatcher, responseChunkBytes));
+        }
+    }
+
+    void removeFinishedConnections()
+    {
+        for (int index = connections.size(); --index >= 0;)
+        {
+            if (!connections.getUnchecked(index)->isThreadRunning())
+            {
+                connections.remove(index);
+            }
+        }
+    }
+
+    VoicevoxServerDispatcher& dispatcher;
+    const size_t responseChunkBytes;
+
+    juce::StreamingSocket listenerSocket;
+    juce::OwnedArray<VoicevoxServerConnection> connections;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VoicevoxServerListener)
+};
+
+//==============================================================================
+VoicevoxServer::VoicevoxServer()
+    : voicevoxClient(nullptr)
+    , dispatcher(nullptr)
+    , listener(nullptr)
+{
+}
+
+VoicevoxServer::~VoicevoxServer()
+{
+    stop();
+}
+
+//==============================================================================
+juce::Result VoicevoxServer::start(const VoicevoxServerOptions& options)
+{
+    stop();
+
+    currentOptions = options;
+
+    voicevoxClient = std::make_unique<voicevox::VoicevoxClient>();
+    voicevoxClient->connect();
+
+    dispatcher = std::make_unique<voicevox::VoicevoxServerDispatcher>(*voicevoxClient, currentOptions);
+    listener = std::make_unique<voicevox::VoicevoxServerListener>(*dispatcher, currentOptions.responseChunkBytes);
+
+    if (!listener->listen(currentOptions.port))
+    {
+        stop();
+        return juce::Result::fail("Failed to listen on port " + juce::String(options.port));
+    }
+
+    VoicevoxEventLog::log(VoicevoxLogLevel::Info, VoicevoxEventId::ServerListening, 0, 0, 0, getPort());
+
+    return juce::Result::ok();
+}
+
+void VoicevoxServer::stop()
+{
+    // NOTE: Requests not yet picked up by a worker are failed with a disconnected status first, connections waiting
+    //       on a running call give up within their poll interval, then the workers are joined after their current call.
+    if (dispatcher != nullptr)
+    {
+        dispatcher->cancelPendingRequests();
+    }
+
+    listener.reset();
+    dispatcher.reset();
+
+    if (voicevoxClient != nullptr)
+    {
+        voicevoxClient->disconnect();
+        voicevoxClient.reset();
+    }
+}
+
+bool VoicevoxServer::isRunning() const
+{
+    return listener != nullptr;
+}
+
+int VoicevoxServer::getPort() const
+{
+    return listener != nullptr ? listener->getPort() : -1;
+}
+
+}
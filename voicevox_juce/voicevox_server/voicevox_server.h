@@ -0,0 +1,65 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+namespace voicevox
+{
+
+class VoicevoxClient;
+class VoicevoxServerListener;
+class VoicevoxServerDispatcher;
+
+//==============================================================================
+struct VoicevoxServerOptions
+{
+    // NOTE: Default port is shifted from VOICEVOX ENGINE (50021) to avoid conflict.
+    int port{ 50121 };
+
+    // Requests run on this many threads, so that one long render does not hold up the other processes.
+    int numWorkerThreads{ 2 };
+
+    // Song stage requests of one speaker arriving within this window are coalesced into one core call
+    // through VoicevoxPhraseBatcher, 0 disables coalescing. Other requests are never held back.
+    int batchWindowMilliseconds{ 5 };
+    int maxBatchSize{ 16 };
+
+    // Size of each chunk when streaming a response body.
+    size_t responseChunkBytes{ 64 * 1024 };
+};
+
+//==============================================================================
+/**
+    Serves one VoicevoxClient to other processes over a loopback socket,
+    so that several processes can share a single set of loaded models.
+
+    NOTE: Coalesced song stages are rendered with silent padding between the
+          requests, see VoicevoxPhraseBatcher for how close that is to a
+          separate render.
+
+    Use VoicevoxRemoteClient to talk to it.
+*/
+class VoicevoxServer final
+{
+public:
+    //==============================================================================
+    VoicevoxServer();
+    ~VoicevoxServer();
+
+    //==============================================================================
+    juce::Result start(const VoicevoxServerOptions& options = {});
+    void stop();
+    bool isRunning() const;
+
+    int getPort() const;
+
+private:
+    //==============================================================================
+    std::unique_ptr<voicevox::VoicevoxClient> voicevoxClient;
+    std::unique_ptr<voicevox::VoicevoxServerDispatcher> dispatcher;
+    std::unique_ptr<voicevox::VoicevoxServerListener> listener;
+    VoicevoxServerOptions currentOptions;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VoicevoxServer)
+};
+
+}
@@ -0,0 +1,215 @@
+#include "voicevox_server_protocol.h"
+
+namespace voicevox
+{
+
+//==============================================================================
+bool VoicevoxServerProtocol::readExactly(juce::StreamingSocket& socket, void* dest, size_t num_bytes, int timeout_milliseconds)
+{
+    auto* dest_bytes = static_cast<char*>(dest);
+
+    while (num_bytes > 0)
+    {
+        if (socket.waitUntilReady(true, timeout_milliseconds) <= 0)
+        {
+            return false;
+        }
+
+        const auto num_read = socket.read(dest_bytes, (int)num_bytes, true);
+        if (num_read <= 0)
+        {
+            return false;
+        }
+
+        dest_bytes += num_read;
+        num_bytes -= (size_t)num_read;
+    }
+
+    return true;
+}
+
+bool VoicevoxServerProtocol::writeExactly(juce::StreamingSocket& socket, const void* source, size_t num_bytes)
+{
+    const auto* source_bytes = static_cast<const char*>(source);
+
+    while (num_bytes > 0)
+    {
+        const auto num_written = socket.write(source_bytes, (int)num_bytes);
+        if (num_written <= 0)
+        {
+            return false;
+        }
+
+        source_bytes += num_written;
+        num_bytes -= (size_t)num_written;
+    }
+
+    return true;
+}
+
+//==============================================================================
+bool VoicevoxServerProtocol::writeRequest(juce::StreamingSocket& socket, const VoicevoxServerRequestHeader& header, const juce::MemoryBlock& payload)
+{
+    const juce::uint32 header_words[] = {
+        juce::ByteOrder::swapIfBigEndian(magic),
+        juce::ByteOrder::swapIfBigEndian((juce::uint32)header.method),
+        juce::ByteOrder::swapIfBigEndian(header.speakerId),
+        juce::ByteOrder::swapIfBigEndian((juce::uint32)payload.getSize())
+    };
+
+    return writeExactly(socket, header_words, sizeof(header_words))
+        && writeExactly(socket, payload.getData(), payload.getSize());
+}
+
+bool VoicevoxServerProtocol::readRequestHeader(juce::StreamingSocket& socket, VoicevoxServerRequestHeader& header)
+{
+    juce::uint32 header_words[4]{};
+
+    if (!readExactly(socket, header_words, sizeof(header_words)))
+    {
+        return false;
+    }
+
+    if (juce::ByteOrder::swapIfBigEndian(header_words[0]) != magic)
+    {
+        return false;
+    }
+
+    header.method = (VoicevoxServerMethod)juce::ByteOrder::swapIfBigEndian(header_words[1]);
+    header.speakerId = juce::ByteOrder::swapIfBigEndian(header_words[2]);
+    header.payloadSize = juce::ByteOrder::swapIfBigEndian(header_words[3]);
+
+    return header.payloadSize <= maxPayloadSize;
+}
+
+//==============================================================================
+bool VoicevoxServerProtocol::writeResponse(juce::StreamingSocket& socket, VoicevoxServerStatus status, const juce::MemoryBlock& body, size_t chunk_size)
+{
+    jassert(chunk_size > 0);
+
+    if (!writeResponseHeader(socket, status))
+    {
+        return false;
+    }
+
+    // NOTE: Long results are split into chunks, so that neither end has to handle the whole body as one transfer.
+    const auto* body_bytes = static_cast<const char*>(body.getData());
+    size_t offset = 0;
+
+    while (offset < body.getSize())
+    {
+        const auto num_bytes = std::min(chunk_size, body.getSize() - offset);
+
+        if (!writeResponseChunk(socket, body_bytes + offset, num_bytes))
+        {
+            return false;
+        }
+
+        offset += num_bytes;
+    }
+
+    return writeResponseEnd(socket);
+}
+
+bool VoicevoxServerProtocol::readResponse(juce::StreamingSocket& socket, VoicevoxServerStatus& status, juce::MemoryBlock& body, int timeout_milliseconds)
+{
+    if (!readResponseHeader(socket, status, timeout_milliseconds))
+    {
+        return false;
+    }
+
+    body.reset();
+
+    for (;;)
+    {
+        juce::MemoryBlock chunk;
+        if (!readResponseChunk(socket, chunk, timeout_milliseconds))
+        {
+            return false;
+        }
+
+        if (chunk.getSize() == 0)
+        {
+            return true;
+        }
+
+        if (body.getSize() + chunk.getSize() > maxPayloadSize)
+        {
+            return false;
+        }
+
+        body.append(chunk.getData(), chunk.getSize());
+    }
+}
+
+//==============================================================================
+bool VoicevoxServerProtocol::writeResponseHeader(juce::StreamingSocket& socket, VoicevoxServerStatus status)
+{
+    const juce::uint32 header_words[] = {
+        juce::ByteOrder::swapIfBigEndian(magic),
+        juce::ByteOrder::swapIfBigEndian((juce::uint32)status)
+    };
+
+    return writeExactly(socket, header_words, sizeof(header_words));
+}
+
+bool VoicevoxServerProtocol::writeResponseChunk(juce::StreamingSocket& socket, const void* data, size_t num_bytes)
+{
+    // NOTE: A zero sized chunk would be read as the end of the body.
+    if (num_bytes == 0)
+    {
+        return true;
+    }
+
+    jassert(num_bytes <= maxPayloadSize);
+
+    const auto chunk_header = juce::ByteOrder::swapIfBigEndian((juce::uint32)num_bytes);
+
+    return writeExactly(socket, &chunk_header, sizeof(chunk_header))
+        && writeExactly(socket, data, num_bytes);
+}
+
+bool VoicevoxServerProtocol::writeResponseEnd(juce::StreamingSocket& socket)
+{
+    const juce::uint32 terminator = 0;
+    return writeExactly(socket, &terminator, sizeof(terminator));
+}
+
+bool VoicevoxServerProtocol::readResponseHeader(juce::StreamingSocket& socket, VoicevoxServerStatus& status, int timeout_milliseconds)
+{
+    juce::uint32 header_words[2]{};
+
+    if (!readExactly(socket, header_words, sizeof(header_words), timeout_milliseconds))
+    {
+        return false;
+    }
+
+    if (juce::ByteOrder::swapIfBigEndian(header_words[0]) != magic)
+    {
+        return false;
+    }
+
+    status = (VoicevoxServerStatus)juce::ByteOrder::swapIfBigEndian(header_words[1]);
+    return true;
+}
+
+bool VoicevoxServerProtocol::readResponseChunk(juce::StreamingSocket& socket, juce::MemoryBlock& chunk, int timeout_milliseconds)
+{
+    juce::uint32 chunk_header = 0;
+    if (!readExactly(socket, &chunk_header, sizeof(chunk_header), timeout_milliseconds))
+    {
+        return false;
+    }
+
+    const auto num_bytes = (size_t)juce::ByteOrder::swapIfBigEndian(chunk_header);
+    if (num_bytes > maxPayloadSize)
+    {
+        return false;
+    }
+
+    chunk.setSize(num_bytes, false);
+
+    return readExactly(socket, chunk.getData(), num_bytes, timeout_milliseconds);
+}
+
+}
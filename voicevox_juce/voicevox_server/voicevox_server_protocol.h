@@ -0,0 +1,124 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+namespace voicevox
+{
+
+//==============================================================================
+enum class VoicevoxServerMethod : juce::uint32
+{
+    GetMetasJson = 1,
+    LoadModel,
+    IsModelLoaded,
+    GetSampleRate,
+    Synthesis,
+    Tts,
+    PredictSingConsonantLength,
+    PredictSingF0,
+    PredictSingVolume,
+    SingBySfDecode,
+    SingBySfDecodeStreaming
+};
+
+enum class VoicevoxServerStatus : juce::uint32
+{
+    Ok = 0,
+    Failed,
+    Disconnected,
+    BadRequest
+};
+
+struct VoicevoxServerRequestHeader
+{
+    VoicevoxServerMethod method{};
+    juce::uint32 speakerId{ 0 };
+    juce::uint32 payloadSize{ 0 };
+};
+
+//==============================================================================
+/**
+    Wire format shared by VoicevoxServer and VoicevoxRemoteClient.
+
+    Request  : [magic][method][speaker_id][payload_size][payload]
+    Response : [magic][status]([chunk_size][chunk])...[0]
+
+    All header fields are little endian uint32. The payload and response body
+    carry raw native arrays because both ends always live on the same machine.
+
+    SingBySfDecodeStreaming sends every decoded chunk as soon as it is ready.
+    The status is then sent with the first chunk, so a stream which fails
+    half way is ended by closing the connection.
+*/
+struct VoicevoxServerProtocol
+{
+    static constexpr juce::uint32 magic = 0x314a5656; // "VVJ1"
+    static constexpr juce::uint32 maxPayloadSize = 256 * 1024 * 1024;
+
+    //==============================================================================
+    static bool writeRequest(juce::StreamingSocket& socket, const VoicevoxServerRequestHeader& header, const juce::MemoryBlock& payload);
+    static bool readRequestHeader(juce::StreamingSocket& socket, VoicevoxServerRequestHeader& header);
+
+    static bool writeResponse(juce::StreamingSocket& socket, VoicevoxServerStatus status, const juce::MemoryBlock& body, size_t chunk_size);
+    static bool readResponse(juce::StreamingSocket& socket, VoicevoxServerStatus& status, juce::MemoryBlock& body, int timeout_milliseconds = -1);
+
+    // Pieces of a response, for bodies which are sent while they are still being computed.
+    static bool writeResponseHeader(juce::StreamingSocket& socket, VoicevoxServerStatus status);
+    static bool writeResponseChunk(juce::StreamingSocket& socket, const void* data, size_t num_bytes);
+    static bool writeResponseEnd(juce::StreamingSocket& socket);
+
+    static bool readResponseHeader(juce::StreamingSocket& socket, VoicevoxServerStatus& status, int timeout_milliseconds = -1);
+
+    // An empty chunk marks the end of the body.
+    static bool readResponseChunk(juce::StreamingSocket& socket, juce::MemoryBlock& chunk, int timeout_milliseconds = -1);
+
+    // Fails when no data arrives for timeout_milliseconds, -1 waits forever.
+    static bool readExactly(juce::StreamingSocket& socket, void* dest, size_t num_bytes, int timeout_milliseconds = -1);
+    static bool writeExactly(juce::StreamingSocket& socket, const void* source, size_t num_bytes);
+
+    //==============================================================================
+    template <typename ElementType>
+    static void writeArray(juce::MemoryOutputStream& stream, const ElementType* elements, size_t num_elements)
+    {
+        static_assert(std::is_trivially_copyable_v<ElementType>);
+
+        stream.writeInt64((juce::int64)num_elements);
+        stream.write(elements, num_elements * sizeof(ElementType));
+    }
+
+    template <typename ElementType>
+    static void writeVector(juce::MemoryOutputStream& stream, const std::vector<ElementType>& vector)
+    {
+        writeArray(stream, vector.data(), vector.size());
+    }
+
+    template <typename ElementType>
+    static std::optional<std::vector<ElementType>> readVector(juce::MemoryInputStream& stream)
+    {
+        static_assert(std::is_trivially_copyable_v<ElementType>);
+
+        const auto num_elements = stream.readInt64();
+        if (num_elements < 0 || (juce::uint64)num_elements * sizeof(ElementType) > (juce::uint64)stream.getNumBytesRemaining())
+        {
+            return std::nullopt;
+        }
+
+        std::vector<ElementType> vector((size_t)num_elements);
+        stream.read(vector.data(), (int)(vector.size() * sizeof(ElementType)));
+
+        return vector;
+    }
+
+    template <typename ElementType>
+    static std::vector<ElementType> toVector(const juce::MemoryBlock& block)
+    {
+        static_assert(std::is_trivially_copyable_v<ElementType>);
+
+        std::vector<ElementType> vector(block.getSize() / sizeof(ElementType));
+        block.copyTo(vector.data(), 0, vector.size() * sizeof(ElementType));
+
+        return vector;
+    }
+};
+
+}
@@ -0,0 +1,348 @@
+#include "voicevox_thread_placement.h"
+#include "../voicevox_memory/voicevox_frame_arena.h"
+
+#if JUCE_LINUX
+ #include <pthread.h>
+ #include <sched.h>
+#endif
+
+namespace voicevox
+{
+
+//==============================================================================
+VoicevoxCpuSet::VoicevoxCpuSet(std::initializer_list<int> cpu_indices)
+{
+    for (const auto cpu : cpu_indices)
+    {
+        add(cpu);
+    }
+}
+
+std::optional<VoicevoxCpuSet> VoicevoxCpuSet::fromString(const juce::String& cpu_list)
+{
+    VoicevoxCpuSet cpu_set;
+
+    for (const auto& token : juce::StringArray::fromTokens(cpu_list.trim(), ",", ""))
+    {
+        const auto item = token.trim();
+        if (item.isEmpty())
+        {
+            continue;
+        }
+
+        const auto is_range = item.containsChar('-');
+        const auto first_text = is_range ? item.upToFirstOccurrenceOf("-", false, false).trim() : item;
+        const auto last_text = is_range ? item.fromFirstOccurrenceOf("-", false, false).trim() : item;
+
+        if (!first_text.containsOnly("0123456789") || !last_text.containsOnly("0123456789") || first_text.isEmpty() || last_text.isEmpty())
+        {
+            return std::nullopt;
+        }
+
+        const auto first_cpu = first_text.getIntValue();
+        const auto last_cpu = last_text.getIntValue();
+        if (first_cpu > last_cpu || last_cpu >= maxNumCpus)
+        {
+            return std::nullopt;
+        }
+
+        for (auto cpu = first_cpu; cpu <= last_cpu; cpu++)
+        {
+            cpu_set.add(cpu);
+        }
+    }
+
+    return cpu_set;
+}
+
+VoicevoxCpuSet VoicevoxCpuSet::fromRange(int first_cpu, int num_cpus)
+{
+    VoicevoxCpuSet cpu_set;
+
+    for (auto cpu = first_cpu; cpu < first_cpu + num_cpus; cpu++)
+    {
+        cpu_set.add(cpu);
+    }
+
+    return cpu_set;
+}
+
+std::optional<VoicevoxCpuSet> VoicevoxCpuSet::fromNumaNode(int numa_node)
+{
+#if JUCE_LINUX
+    const auto cpu_list_file = juce::File("/sys/devices/system/node/node" + juce::String(numa_node) + "/cpulist");
+    if (!cpu_list_file.existsAsFile())
+    {
+        return std::nullopt;
+    }
+
+    return fromString(cpu_list_file.loadFileAsString());
+#else
+    juce::ignoreUnused(numa_node);
+    return std::nullopt;
+#endif
+}
+
+//==============================================================================
+void VoicevoxCpuSet::add(int cpu) noexcept
+{
+    jassert(juce::isPositiveAndBelow(cpu, maxNumCpus));
+
+    if (juce::isPositiveAndBelow(cpu, maxNumCpus))
+    {
+        cpus.set((size_t)cpu);
+    }
+}
+
+void VoicevoxCpuSet::remove(int cpu) noexcept
+{
+    if (juce::isPositiveAndBelow(cpu, maxNumCpus))
+    {
+        cpus.reset((size_t)cpu);
+    }
+}
+
+bool VoicevoxCpuSet::contains(int cpu) const noexcept
+{
+    return juce::isPositiveAndBelow(cpu, maxNumCpus) && cpus.test((size_t)cpu);
+}
+
+std::vector<int> VoicevoxCpuSet::getCpus() const
+{
+    std::vector<int> cpu_indices;
+    cpu_indices.reserve(cpus.count());
+
+    for (auto cpu = 0; cpu < maxNumCpus; cpu++)
+    {
+        if (cpus.test((size_t)cpu))
+        {
+            cpu_indices.push_back(cpu);
+        }
+    }
+
+    return cpu_indices;
+}
+
+juce::String VoicevoxCpuSet::toString() const
+{
+    juce::StringArray items;
+
+    for (auto cpu = 0; cpu < maxNumCpus; cpu++)
+    {
+        if (!cpus.test((size_t)cpu))
+        {
+            continue;
+        }
+
+        auto last_cpu = cpu;
+        while (last_cpu + 1 < maxNumCpus && cpus.test((size_t)(last_cpu + 1)))
+        {
+            last_cpu++;
+        }
+
+        items.add(last_cpu == cpu ? juce::String(cpu) : juce::String(cpu) + "-" + juce::String(last_cpu));
+        cpu = last_cpu;
+    }
+
+    return items.joinIntoString(",");
+}
+
+//==============================================================================
+namespace
+{
+    struct ThreadPlacementState
+    {
+        juce::SpinLock lock;
+        VoicevoxThreadPlacementOptions options;
+
+        // Bumped by every setOptions() call, worker threads compare it with the one they applied.
+        std::atomic<juce::uint32> generation{ 1 };
+
+        // NOTE: Taken before anything is pinned, threads created by a pinned thread inherit its affinity
+        //       and can't be used to find the CPUs of the process later on.
+        const std::optional<VoicevoxCpuSet> processCpus{ VoicevoxThreadPlacement::getCurrentThreadAffinity() };
+    };
+
+    struct ThreadPlacementApplied
+    {
+        juce::uint32 generation{ 0 };
+        bool isPinned{ false };
+    };
+
+    ThreadPlacementState& getThreadPlacementState()
+    {
+        static ThreadPlacementState state;
+        return state;
+    }
+}
+
+void VoicevoxThreadPlacement::setOptions(const VoicevoxThreadPlacementOptions& options)
+{
+    auto& state = getThreadPlacementState();
+
+    {
+        const juce::SpinLock::ScopedLockType lock(state.lock);
+        state.options = options;
+    }
+
+    state.generation++;
+
+    VoicevoxFrameArena::setFirstTouchNewBlocks(options.useFirstTouchAllocation);
+}
+
+VoicevoxThreadPlacementOptions VoicevoxThreadPlacement::getOptions()
+{
+    auto& state = getThreadPlacementState();
+
+    const juce::SpinLock::ScopedLockType lock(state.lock);
+    return state.options;
+}
+
+int VoicevoxThreadPlacement::getNumInferenceThreads()
+{
+    const auto options = getOptions();
+
+    if (options.numInferenceThreads > 0)
+    {
+        return options.numInferenceThreads;
+    }
+
+    return options.inferenceCpus.size();
+}
+
+//==============================================================================
+namespace
+{
+    void applyThreadPlacement(ThreadPlacementApplied& applied, VoicevoxCpuSet VoicevoxThreadPlacementOptions::*cpus)
+    {
+        auto& state = getThreadPlacementState();
+        const auto generation = state.generation.load();
+
+        if (applied.generation == generation)
+        {
+            return;
+        }
+
+        applied.generation = generation;
+
+        const auto target_cpus = VoicevoxThreadPlacement::getOptions().*cpus;
+        if (!target_cpus.isEmpty())
+        {
+            // NOTE: A failed call leaves the thread where it was, pinned or not.
+            if (VoicevoxThreadPlacement::setCurrentThreadAffinity(target_cpus))
+            {
+                applied.isPinned = true;
+            }
+        }
+        else if (applied.isPinned && state.processCpus.has_value())
+        {
+            VoicevoxThreadPlacement::setCurrentThreadAffinity(*state.processCpus);
+            applied.isPinned = false;
+        }
+    }
+}
+
+void VoicevoxThreadPlacement::applyWorkerAffinity()
+{
+    thread_local ThreadPlacementApplied applied;
+    applyThreadPlacement(applied, &VoicevoxThreadPlacementOptions::workerCpus);
+}
+
+void VoicevoxThreadPlacement::applyInferenceAffinity()
+{
+    thread_local ThreadPlacementApplied applied;
+    applyThreadPlacement(applied, &VoicevoxThreadPlacementOptions::inferenceCpus);
+}
+
+std::optional<VoicevoxCpuSet> VoicevoxThreadPlacement::getProcessAffinity()
+{
+    return getThreadPlacementState().processCpus;
+}
+
+//==============================================================================
+bool VoicevoxThreadPlacement::isSupported() noexcept
+{
+#if JUCE_LINUX
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool VoicevoxThreadPlacement::setCurrentThreadAffinity(const VoicevoxCpuSet& cpus)
+{
+#if JUCE_LINUX
+    cpu_set_t native_cpu_set;
+    CPU_ZERO(&native_cpu_set);
+
+    // NOTE: Walk the bits instead of building a vector, maxNumCpus is far larger than most sets.
+    for (auto cpu = 0; cpu < std::min<int>(CPU_SETSIZE, VoicevoxCpuSet::maxNumCpus); cpu++)
+    {
+        if (cpus.contains(cpu))
+        {
+            CPU_SET(cpu, &native_cpu_set);
+        }
+    }
+
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &native_cpu_set) == 0;
+#else
+    juce::ignoreUnused(cpus);
+    return true;
+#endif
+}
+
+std::optional<VoicevoxCpuSet> VoicevoxThreadPlacement::getCurrentThreadAffinity()
+{
+#if JUCE_LINUX
+    cpu_set_t native_cpu_set;
+    CPU_ZERO(&native_cpu_set);
+
+    if (pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), &native_cpu_set) != 0)
+    {
+        return std::nullopt;
+    }
+
+    VoicevoxCpuSet cpu_set;
+    for (auto cpu = 0; cpu < std::min<int>(CPU_SETSIZE, VoicevoxCpuSet::maxNumCpus); cpu++)
+    {
+        if (CPU_ISSET(cpu, &native_cpu_set))
+        {
+            cpu_set.add(cpu);
+        }
+    }
+
+    return cpu_set;
+#else
+    return std::nullopt;
+#endif
+}
+
+//==============================================================================
+VoicevoxScopedThreadAffinity::VoicevoxScopedThreadAffinity(const VoicevoxCpuSet& cpus)
+{
+    if (cpus.isEmpty() || !VoicevoxThreadPlacement::isSupported())
+    {
+        return;
+    }
+
+    previousCpus = VoicevoxThreadPlacement::getCurrentThreadAffinity();
+
+    if (previousCpus.has_value() && *previousCpus != cpus)
+    {
+        VoicevoxThreadPlacement::setCurrentThreadAffinity(cpus);
+    }
+    else
+    {
+        previousCpus.reset();
+    }
+}
+
+VoicevoxScopedThreadAffinity::~VoicevoxScopedThreadAffinity()
+{
+    if (previousCpus.has_value())
+    {
+        VoicevoxThreadPlacement::setCurrentThreadAffinity(*previousCpus);
+    }
+}
+
+}
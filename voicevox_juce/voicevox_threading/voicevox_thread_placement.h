@@ -0,0 +1,123 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <bitset>
+
+namespace voicevox
+{
+
+//==============================================================================
+/** Set of logical CPU indices. */
+class VoicevoxCpuSet final
+{
+public:
+    //==============================================================================
+    static constexpr int maxNumCpus = 1024;
+
+    VoicevoxCpuSet() = default;
+    VoicevoxCpuSet(std::initializer_list<int> cpu_indices);
+
+    // Parses the cpulist syntax of Linux, for example "0-7,16,18-19".
+    static std::optional<VoicevoxCpuSet> fromString(const juce::String& cpu_list);
+    static VoicevoxCpuSet fromRange(int first_cpu, int num_cpus);
+
+    // CPUs of one NUMA node as reported by sysfs, nullopt when unknown.
+    static std::optional<VoicevoxCpuSet> fromNumaNode(int numa_node);
+
+    //==============================================================================
+    void add(int cpu) noexcept;
+    void remove(int cpu) noexcept;
+    bool contains(int cpu) const noexcept;
+
+    bool isEmpty() const noexcept { return cpus.none(); }
+    int size() const noexcept { return (int)cpus.count(); }
+
+    std::vector<int> getCpus() const;
+    juce::String toString() const;
+
+    bool operator==(const VoicevoxCpuSet& other) const noexcept { return cpus == other.cpus; }
+    bool operator!=(const VoicevoxCpuSet& other) const noexcept { return cpus != other.cpus; }
+
+private:
+    //==============================================================================
+    std::bitset<maxNumCpus> cpus;
+};
+
+//==============================================================================
+struct VoicevoxThreadPlacementOptions
+{
+    // ONNX runtime threads and the threads calling into the core run here, empty leaves placement to the OS.
+    VoicevoxCpuSet inferenceCpus{};
+
+    // Pre / post processing threads of the module run here, empty leaves placement to the OS.
+    VoicevoxCpuSet workerCpus{};
+
+    // Passed to voicevox_initialize as cpu_num_threads, 0 uses the number of inference CPUs if any, otherwise the core default.
+    int numInferenceThreads{ 0 };
+
+    // Touches new arena blocks from the allocating thread, so that the first-touch policy places their pages on its NUMA node.
+    // NOTE: No memory policy is set, pages already touched or migrated by the kernel stay where they are.
+    bool useFirstTouchAllocation{ false };
+};
+
+//==============================================================================
+/**
+    Process wide placement of the threads used by the module.
+
+    Affinity is only implemented on Linux, on other platforms every call
+    succeeds without changing anything.
+
+    The effect depends on the machine and the model, and no measurement of it
+    ships with the module. Replay the same trace with VoicevoxTraceReplayer
+    with and without the CPU sets and compare its p50 / p99 latencies before
+    relying on a placement.
+*/
+class VoicevoxThreadPlacement final
+{
+public:
+    //==============================================================================
+    // NOTE: The core picks up the options when VoicevoxCoreHost is created, set them before the first connect().
+    static void setOptions(const VoicevoxThreadPlacementOptions& options);
+    static VoicevoxThreadPlacementOptions getOptions();
+
+    static int getNumInferenceThreads();
+
+    //==============================================================================
+    // Move the calling thread to the worker or inference CPUs, a thread local check when already applied.
+    // A thread that was pinned goes back to the CPUs of the process when its set is cleared by setOptions().
+    // NOTE: The calling thread takes part in the intra-op work of the core, so threads of the application
+    //       which call VoicevoxClient should call applyInferenceAffinity() once before their first call.
+    static void applyWorkerAffinity();
+    static void applyInferenceAffinity();
+
+    // Affinity of the process before any thread was pinned, nullopt when unsupported.
+    static std::optional<VoicevoxCpuSet> getProcessAffinity();
+
+    //==============================================================================
+    static bool isSupported() noexcept;
+    static bool setCurrentThreadAffinity(const VoicevoxCpuSet& cpus);
+    static std::optional<VoicevoxCpuSet> getCurrentThreadAffinity();
+};
+
+//==============================================================================
+/**
+    Pins the calling thread to the given CPUs and restores the previous
+    affinity when going out of scope.
+
+    Threads created in the scope, like the ONNX runtime threads created by
+    voicevox_initialize and voicevox_load_model, inherit the affinity. Does nothing when the set
+    is empty.
+*/
+class VoicevoxScopedThreadAffinity final
+{
+public:
+    explicit VoicevoxScopedThreadAffinity(const VoicevoxCpuSet& cpus);
+    ~VoicevoxScopedThreadAffinity();
+
+private:
+    std::optional<VoicevoxCpuSet> previousCpus;
+
+    JUCE_DECLARE_NON_COPYABLE(VoicevoxScopedThreadAffinity)
+};
+
+}
@@ -0,0 +1,212 @@
+#include "voicevox_trace_recorder.h"
+
+namespace voicevox
+{
+
+namespace
+{
+    constexpr juce::uint8 traceRecordSuccessFlag = 0x01;
+    constexpr juce::uint8 traceRecordInputsFlag = 0x02;
+
+    constexpr juce::uint32 traceFileInputsFlag = 0x01;
+
+    // method + flags + speaker_id + start_us + duration_us + input_checksum + output_checksum + output_bytes + input_bytes
+    constexpr size_t traceRecordHeaderSize = 1 + 1 + 4 + 8 + 4 + 8 + 8 + 8 + 4;
+
+    bool isTraceableMethod(juce::uint8 method)
+    {
+        return method >= (juce::uint8)VoicevoxServerMethod::GetMetasJson
+            && method <= (juce::uint8)VoicevoxServerMethod::SingBySfDecode;
+    }
+}
+
+//==============================================================================
+VoicevoxTraceRecorder::VoicevoxTraceRecorder()
+    : openTicks(0)
+    , numRecords(0)
+{
+}
+
+VoicevoxTraceRecorder::~VoicevoxTraceRecorder()
+{
+    close();
+}
+
+//==============================================================================
+juce::Result VoicevoxTraceRecorder::open(const juce::File& trace_file, const VoicevoxTraceRecorderOptions& options)
+{
+    const juce::ScopedLock lock(writeLock);
+
+    outputStream.reset();
+
+    auto file_output_stream = std::make_unique<juce::FileOutputStream>(trace_file);
+    if (file_output_stream->failedToOpen())
+    {
+        return file_output_stream->getStatus();
+    }
+
+    // NOTE: A trace always starts from scratch, appending would break the relative timestamps.
+    file_output_stream->setPosition(0);
+    file_output_stream->truncate();
+
+    file_output_stream->writeInt((int)magic);
+    file_output_stream->writeInt((int)version);
+    file_output_stream->writeInt((int)(options.recordInputs ? traceFileInputsFlag : 0));
+    file_output_stream->writeInt64(juce::Time::currentTimeMillis());
+
+    if (file_output_stream->getStatus().failed())
+    {
+        return file_output_stream->getStatus();
+    }
+
+    outputStream = std::move(file_output_stream);
+    recorderOptions = options;
+    openTicks = juce::Time::getHighResolutionTicks();
+    numRecords = 0;
+
+    return juce::Result::ok();
+}
+
+void VoicevoxTraceRecorder::close()
+{
+    const juce::ScopedLock lock(writeLock);
+
+    if (outputStream != nullptr)
+    {
+        outputStream->flush();
+        outputStream.reset();
+    }
+}
+
+bool VoicevoxTraceRecorder::isOpen() const
+{
+    const juce::ScopedLock lock(writeLock);
+    return outputStream != nullptr;
+}
+
+//==============================================================================
+void VoicevoxTraceRecorder::record(VoicevoxServerMethod method, juce::uint32 speaker_id, juce::int64 start_ticks, juce::int64 end_ticks, const juce::MemoryBlock& inputs, bool is_success, const void* output_data, size_t output_num_bytes)
+{
+    // NOTE: Hash outside of the lock, outputs of song decode are several megabytes.
+    record(method, speaker_id, start_ticks, end_ticks, inputs, is_success, checksum(output_data, output_num_bytes), (juce::uint64)output_num_bytes);
+}
+
+void VoicevoxTraceRecorder::record(VoicevoxServerMethod method, juce::uint32 speaker_id, juce::int64 start_ticks, juce::int64 end_ticks, const juce::MemoryBlock& inputs, bool is_success, juce::uint64 output_checksum, juce::uint64 output_num_bytes)
+{
+    const auto input_checksum = checksum(inputs.getData(), inputs.getSize());
+
+    const juce::ScopedLock lock(writeLock);
+
+    if (outputStream == nullptr)
+    {
+        return;
+    }
+
+    const auto start_microseconds = (juce::int64)(juce::Time::highResolutionTicksToSeconds(start_ticks - openTicks) * 1.0e6);
+    const auto duration_microseconds = (juce::int64)(juce::Time::highResolutionTicksToSeconds(end_ticks - start_ticks) * 1.0e6);
+    const auto has_inputs = recorderOptions.recordInputs;
+
+    juce::uint8 flags = 0;
+    flags |= is_success ? traceRecordSuccessFlag : 0;
+    flags |= has_inputs ? traceRecordInputsFlag : 0;
+
+    outputStream->writeByte((char)method);
+    outputStream->writeByte((char)flags);
+    outputStream->writeInt((int)speaker_id);
+    outputStream->writeInt64(start_microseconds);
+    outputStream->writeInt((int)juce::jlimit<juce::int64>(0, std::numeric_limits<juce::uint32>::max(), duration_microseconds));
+    outputStream->writeInt64((juce::int64)input_checksum);
+    outputStream->writeInt64((juce::int64)output_checksum);
+    outputStream->writeInt64((juce::int64)output_num_bytes);
+    outputStream->writeInt(has_inputs ? (int)inputs.getSize() : 0);
+
+    if (has_inputs)
+    {
+        outputStream->write(inputs.getData(), inputs.getSize());
+    }
+
+    numRecords++;
+}
+
+juce::uint64 VoicevoxTraceRecorder::getNumRecords() const noexcept
+{
+    return numRecords.load();
+}
+
+//==============================================================================
+std::optional<std::vector<VoicevoxTraceRecord>> VoicevoxTraceRecorder::readTrace(const juce::File& trace_file)
+{
+    juce::FileInputStream stream(trace_file);
+    if (stream.failedToOpen())
+    {
+        return std::nullopt;
+    }
+
+    if ((juce::uint32)stream.readInt() != magic || (juce::uint32)stream.readInt() != version)
+    {
+        return std::nullopt;
+    }
+
+    stream.readInt();   // file flags
+    stream.readInt64(); // start time
+
+    std::vector<VoicevoxTraceRecord> records;
+
+    while (stream.getNumBytesRemaining() > 0)
+    {
+        if (stream.getNumBytesRemaining() < (juce::int64)traceRecordHeaderSize)
+        {
+            // NOTE: Truncated tail of a trace that was not closed, keep what is complete.
+            break;
+        }
+
+        const auto method = (juce::uint8)stream.readByte();
+        const auto flags = (juce::uint8)stream.readByte();
+        if (!isTraceableMethod(method))
+        {
+            return std::nullopt;
+        }
+
+        VoicevoxTraceRecord record;
+        record.method = (VoicevoxServerMethod)method;
+        record.isSuccess = (flags & traceRecordSuccessFlag) != 0;
+        record.hasInputs = (flags & traceRecordInputsFlag) != 0;
+        record.speakerId = (juce::uint32)stream.readInt();
+        record.startMicroseconds = stream.readInt64();
+        record.durationMicroseconds = (juce::uint32)stream.readInt();
+        record.inputChecksum = (juce::uint64)stream.readInt64();
+        record.outputChecksum = (juce::uint64)stream.readInt64();
+        record.outputNumBytes = (juce::uint64)stream.readInt64();
+
+        const auto input_num_bytes = (juce::uint32)stream.readInt();
+        if ((juce::int64)input_num_bytes > stream.getNumBytesRemaining())
+        {
+            break;
+        }
+
+        if (input_num_bytes > 0)
+        {
+            record.inputs.setSize(input_num_bytes);
+            stream.read(record.inputs.getData(), (int)input_num_bytes);
+        }
+
+        records.push_back(std::move(record));
+    }
+
+    return records;
+}
+
+juce::uint64 VoicevoxTraceRecorder::checksum(const void* data, size_t num_bytes, juce::uint64 hash) noexcept
+{
+    // 64 bit FNV-1a
+    const auto* bytes = static_cast<const juce::uint8*>(data);
+    for (size_t index = 0; index < num_bytes; index++)
+    {
+        hash ^= bytes[index];
+        hash *= 0x100000001b3ull;
+    }
+
+    return hash;
+}
+
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "../voicevox_server/voicevox_server_protocol.h"
+
+namespace voicevox
+{
+
+//==============================================================================
+/** One recorded API call, inputs are serialized in the payload format of VoicevoxServerProtocol. */
+struct VoicevoxTraceRecord
+{
+    VoicevoxServerMethod method{ VoicevoxServerMethod::GetMetasJson };
+    juce::uint32 speakerId{ 0 };
+
+    // Relative to the start of the recording.
+    juce::int64 startMicroseconds{ 0 };
+    juce::uint32 durationMicroseconds{ 0 };
+
+    bool isSuccess{ false };
+    bool hasInputs{ false };
+
+    juce::uint64 inputChecksum{ 0 };
+    juce::uint64 outputChecksum{ 0 };
+    juce::uint64 outputNumBytes{ 0 };
+
+    // Empty when the trace was recorded with checksums only.
+    juce::MemoryBlock inputs{};
+};
+
+struct VoicevoxTraceRecorderOptions
+{
+    // Inputs are needed for replay, without them only their checksums are kept.
+    bool recordInputs{ true };
+};
+
+//==============================================================================
+/**
+    Writes every API call of a VoicevoxClient to a compact binary trace file.
+
+    File   : [magic][version][flags][start_time_ms] record...
+    Record : [method u8][flags u8][speaker_id u32][start_us i64][duration_us u32]
+             [input_checksum u64][output_checksum u64][output_bytes u64]
+             [input_bytes u32][inputs]
+
+    All fields are little endian. Checksums are 64 bit FNV-1a of the raw bytes.
+
+    VoicevoxClient::singBySfDecodeStreaming is written as a SingBySfDecode record
+    whose inputs are followed by [chunk_frames i64][context_frames i64], the
+    output checksum is taken over the samples of all chunks.
+*/
+class VoicevoxTraceRecorder final
+{
+public:
+    //==============================================================================
+    static constexpr juce::uint32 magic = 0x52545656; // "VVTR"
+    static constexpr juce::uint32 version = 1;
+
+    //==============================================================================
+    VoicevoxTraceRecorder();
+    ~VoicevoxTraceRecorder();
+
+    //==============================================================================
+    juce::Result open(const juce::File& trace_file, const VoicevoxTraceRecorderOptions& options = {});
+    void close();
+    bool isOpen() const;
+
+    // Thread safe, called by VoicevoxClient after every call.
+    void record(VoicevoxServerMethod method, juce::uint32 speaker_id, juce::int64 start_ticks, juce::int64 end_ticks, const juce::MemoryBlock& inputs, bool is_success, const void* output_data, size_t output_num_bytes);
+
+    // For outputs which are produced in chunks, output_checksum is continued over every chunk with checksum().
+    void record(VoicevoxServerMethod method, juce::uint32 speaker_id, juce::int64 start_ticks, juce::int64 end_ticks, const juce::MemoryBlock& inputs, bool is_success, juce::uint64 output_checksum, juce::uint64 output_num_bytes);
+
+    juce::uint64 getNumRecords() const noexcept;
+
+    //==============================================================================
+    static std::optional<std::vector<VoicevoxTraceRecord>> readTrace(const juce::File& trace_file);
+
+    // Pass the previous result as hash to continue over data split into several blocks.
+    static constexpr juce::uint64 initialChecksum = 0xcbf29ce484222325ull;
+    static juce::uint64 checksum(const void* data, size_t num_bytes, juce::uint64 hash = initialChecksum) noexcept;
+
+private:
+    //==============================================================================
+    mutable juce::CriticalSection writeLock;
+    std::unique_ptr<juce::FileOutputStream> outputStream;
+    VoicevoxTraceRecorderOptions recorderOptions;
+    juce::int64 openTicks;
+
+    std::atomic<juce::uint64> numRecords;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VoicevoxTraceRecorder)
+};
+
+}
@@ -0,0 +1,535 @@
+#include "voicevox_trace_replayer.h"
+#include "../voicevox_server/voicevox_remote_client.h"
+#include "../voicevox_threading/voicevox_thread_placement.h"
+
+namespace voicevox
+{
+
+namespace
+{
+    // NOTE: sf_decode_forward function is processed under 24kHz due to hard coded in core library.
+    constexpr double traceSongSampleRate = 24000.0;
+
+    struct TraceReplayCallResult
+    {
+        bool isExecuted{ false };
+        bool isSuccess{ false };
+        juce::uint64 checksum{ 0 };
+        double audioSeconds{ 0.0 };
+    };
+
+    struct TraceReplayStatistics
+    {
+        std::vector<double> latencySeconds;
+        juce::uint64 numFailures{ 0 };
+        juce::uint64 numSkipped{ 0 };
+        juce::uint64 numChecksumMatches{ 0 };
+        juce::uint64 numChecksumMismatches{ 0 };
+        double audioSeconds{ 0.0 };
+        double audioRenderSeconds{ 0.0 };
+    };
+
+    bool isReplayableTraceRecord(const VoicevoxTraceRecord& record)
+    {
+        switch (record.method)
+        {
+        case VoicevoxServerMethod::LoadModel:
+            return true;
+
+        case VoicevoxServerMethod::Synthesis:
+        case VoicevoxServerMethod::Tts:
+        case VoicevoxServerMethod::PredictSingConsonantLength:
+        case VoicevoxServerMethod::PredictSingF0:
+        case VoicevoxServerMethod::PredictSingVolume:
+        case VoicevoxServerMethod::SingBySfDecode:
+            return record.hasInputs;
+
+        default:
+            return false;
+        }
+    }
+
+    template <typename ResultType>
+    TraceReplayCallResult makeTraceReplayCallResult(const std::optional<ResultType>& result, double audio_seconds = 0.0)
+    {
+        TraceReplayCallResult call_result;
+        call_result.isExecuted = true;
+        call_result.isSuccess = result.has_value();
+
+        if (result.has_value())
+        {
+            call_result.checksum = VoicevoxTraceRecorder::checksum(result->data(), result->size() * sizeof(*result->data()));
+            call_result.audioSeconds = audio_seconds;
+        }
+
+        return call_result;
+    }
+
+    // NOTE: Only the RIFF chunks are read, so that replay does not need juce_audio_formats.
+    double getTraceReplayWavSeconds(const std::vector<std::byte>& wav_data)
+    {
+        const auto* data = reinterpret_cast<const char*>(wav_data.data());
+        const auto num_bytes = wav_data.size();
+
+        if (num_bytes < 12 || std::memcmp(data, "RIFF", 4) != 0 || std::memcmp(data + 8, "WAVE", 4) != 0)
+        {
+            return 0.0;
+        }
+
+        juce::uint32 bytes_per_second = 0;
+
+        for (size_t offset = 12; offset + 8 <= num_bytes;)
+        {
+            const auto chunk_num_bytes = (size_t)juce::ByteOrder::littleEndianInt(data + offset + 4);
+            const auto num_bytes_available = num_bytes - offset - 8;
+
+            if (std::memcmp(data + offset, "data", 4) == 0)
+            {
+                return bytes_per_second > 0 ? (double)std::min(chunk_num_bytes, num_bytes_available) / (double)bytes_per_second : 0.0;
+            }
+
+            if (chunk_num_bytes > num_bytes_available)
+            {
+                break;
+            }
+
+            if (std::memcmp(data + offset, "fmt ", 4) == 0 && chunk_num_bytes >= 16)
+            {
+                bytes_per_second = juce::ByteOrder::littleEndianInt(data + offset + 8 + 8);
+            }
+
+            offset += 8 + chunk_num_bytes + (chunk_num_bytes & 1);
+        }
+
+        return 0.0;
+    }
+
+    TraceReplayCallResult makeTraceReplayWavCallResult(const std::optional<std::vector<std::byte>>& wav_data)
+    {
+        return makeTraceReplayCallResult(wav_data, wav_data.has_value() ? getTraceReplayWavSeconds(*wav_data) : 0.0);
+    }
+
+    // NOTE: Inputs are read back in the order VoicevoxClient wrote them, which is the payload order of VoicevoxServer.
+    template <typename ClientType>
+    TraceReplayCallResult executeTraceRecord(ClientType& client, const VoicevoxTraceRecord& record)
+    {
+        juce::MemoryInputStream stream(record.inputs, false);
+        const auto speaker_id = record.speakerId;
+
+        switch (record.method)
+        {
+        case VoicevoxServerMethod::LoadModel:
+        {
+            TraceReplayCallResult call_result;
+            call_result.isExecuted = true;
+            call_result.isSuccess = client.loadModel(speaker_id).wasOk();
+            call_result.checksum = VoicevoxTraceRecorder::checksum(nullptr, 0);
+            return call_result;
+        }
+
+        case VoicevoxServerMethod::Synthesis:
+            return makeTraceReplayWavCallResult(client.synthesis(speaker_id, stream.readString()));
+
+        case VoicevoxServerMethod::Tts:
+            return makeTraceReplayWavCallResult(client.tts(speaker_id, stream.readString()));
+
+        case VoicevoxServerMethod::PredictSingConsonantLength:
+        {
+            const auto consonant = VoicevoxServerProtocol::readVector<std::int64_t>(stream);
+            const auto vowel = VoicevoxServerProtocol::readVector<std::int64_t>(stream);
+            const auto note_length = VoicevoxServerProtocol::readVector<std::int64_t>(stream);
+            if (!consonant.has_value() || !vowel.has_value() || !note_length.has_value())
+            {
+                return {};
+            }
+
+            return makeTraceReplayCallResult(client.predictSingConsonantLength(speaker_id, *consonant, *vowel, *note_length));
+        }
+
+        case VoicevoxServerMethod::PredictSingF0:
+        {
+            const auto phoneme = VoicevoxServerProtocol::readVector<std::int64_t>(stream);
+            const auto note = VoicevoxServerProtocol::readVector<std::int64_t>(stream);
+            if (!phoneme.has_value() || !note.has_value())
+            {
+                return {};
+            }
+
+            return makeTraceReplayCallResult(client.predictSingF0(speaker_id, *phoneme, *note));
+        }
+
+        case VoicevoxServerMethod::PredictSingVolume:
+        {
+            const auto phoneme = VoicevoxServerProtocol::readVector<std::int64_t>(stream);
+            const auto note = VoicevoxServerProtocol::readVector<std::int64_t>(stream);
+            const auto f0 = VoicevoxServerProtocol::readVector<float>(stream);
+            if (!phoneme.has_value() || !note.has_value() || !f0.has_value())
+            {
+                return {};
+            }
+
+            return makeTraceReplayCallResult(client.predictSingVolume(speaker_id, *phoneme, *note, *f0));
+        }
+
+        case VoicevoxServerMethod::SingBySfDecode:
+        {
+            auto phoneme = VoicevoxServerProtocol::readVector<std::int64_t>(stream);
+            auto f0 = VoicevoxServerProtocol::readVector<float>(stream);
+            auto volume = VoicevoxServerProtocol::readVector<float>(stream);
+            if (!phoneme.has_value() || !f0.has_value() || !volume.has_value())
+            {
+                return {};
+            }
+
+            VoicevoxSfDecodeSource decode_source;
+            decode_source.phonemeVector = std::move(*phoneme);
+            decode_source.f0Vector = std::move(*f0);
+            decode_source.volumeVector = std::move(*volume);
+
+            // NOTE: Recorded from singBySfDecodeStreaming, replayed the same way so the checksums stay comparable.
+            if (stream.getNumBytesRemaining() >= (juce::int64)(sizeof(juce::int64) * 2))
+            {
+                const auto chunk_frames = stream.readInt64();
+                const auto context_frames = stream.readInt64();
+                if (chunk_frames <= 0 || context_frames < 0)
+                {
+                    return {};
+                }
+
+                auto output_checksum = VoicevoxTraceRecorder::initialChecksum;
+                size_t num_samples_total = 0;
+
+                const auto result = client.singBySfDecodeStreaming(speaker_id, decode_source,
+                                                                   [&](const float* samples, size_t num_samples)
+                                                                   {
+                                                                       output_checksum = VoicevoxTraceRecorder::checksum(samples, num_samples * sizeof(float), output_checksum);
+                                                                       num_samples_total += num_samples;
+                                                                       return true;
+                                                                   },
+                                                                   (size_t)chunk_frames, (size_t)context_frames);
+
+                TraceReplayCallResult call_result;
+                call_result.isExecuted = true;
+                call_result.isSuccess = result.wasOk();
+
+                if (result.wasOk())
+                {
+                    call_result.checksum = output_checksum;
+                    call_result.audioSeconds = (double)num_samples_total / traceSongSampleRate;
+                }
+
+                return call_result;
+            }
+
+            const auto audio = client.singBySfDecode(speaker_id, decode_source);
+            return makeTraceReplayCallResult(audio, audio.has_value() ? (double)audio->size() / traceSongSampleRate : 0.0);
+        }
+
+        default:
+            return {};
+        }
+    }
+
+    double getTraceReplayPercentile(const std::vector<double>& sorted_values, double percentile)
+    {
+        if (sorted_values.empty())
+        {
+            return 0.0;
+        }
+
+        // Nearest rank.
+        const auto rank = (size_t)std::ceil(percentile * (double)sorted_values.size());
+        return sorted_values[juce::jlimit<size_t>(1, sorted_values.size(), rank) - 1];
+    }
+
+    //==============================================================================
+    using TraceReplayExecuteFunction = std::function<TraceReplayCallResult(int worker_index, const VoicevoxTraceRecord& record)>;
+
+    struct TraceReplaySchedule
+    {
+        std::vector<const VoicevoxTraceRecord*> records;
+        juce::int64 firstStartMicroseconds{ 0 };
+        juce::int64 startTicks{ 0 };
+
+        VoicevoxTraceReplaySpeed speed{ VoicevoxTraceReplaySpeed::Original };
+        double speedScale{ 1.0 };
+
+        std::atomic<size_t> nextIndex{ 0 };
+    };
+
+    class TraceReplayWorker final
+        : public juce::Thread
+    {
+    public:
+        TraceReplayWorker(int worker_index_to_use, TraceReplaySchedule& schedule_to_use, const TraceReplayExecuteFunction& execute_to_use)
+            : juce::Thread("voicevox_trace_replay_" + juce::String(worker_index_to_use))
+            , workerIndex(worker_index_to_use)
+            , schedule(schedule_to_use)
+            , execute(execute_to_use)
+        {
+        }
+
+        ~TraceReplayWorker() override
+        {
+            stopThread(-1);
+        }
+
+        void run() override
+        {
+            while (!threadShouldExit())
+            {
+                const auto index = schedule.nextIndex.fetch_add(1);
+                if (index >= schedule.records.size())
+                {
+                    break;
+                }
+
+                const auto& record = *schedule.records[index];
+                const auto scheduled_ticks = waitUntilScheduled(record);
+
+                const auto start_ticks = juce::Time::getHighResolutionTicks();
+                const auto call_result = execute(workerIndex, record);
+                const auto end_ticks = juce::Time::getHighResolutionTicks();
+
+                // NOTE: Paced latency is measured from the scheduled time, a call that is issued late
+                //       because the worker was still busy has waited that long as well (coordinated omission).
+                const auto latency_seconds = juce::Time::highResolutionTicksToSeconds(end_ticks - scheduled_ticks);
+                const auto render_seconds = juce::Time::highResolutionTicksToSeconds(end_ticks - start_ticks);
+
+                if (!call_result.isExecuted)
+                {
+                    statistics.numSkipped++;
+                    continue;
+                }
+
+                statistics.latencySeconds.push_back(latency_seconds);
+
+                if (!call_result.isSuccess)
+                {
+                    statistics.numFailures++;
+                }
+                else if (record.isSuccess)
+                {
+                    if (call_result.checksum == record.outputChecksum)
+                    {
+                        statistics.numChecksumMatches++;
+                    }
+                    else
+                    {
+                        statistics.numChecksumMismatches++;
+                    }
+                }
+
+                if (call_result.audioSeconds > 0.0)
+                {
+                    statistics.audioSeconds += call_result.audioSeconds;
+                    statistics.audioRenderSeconds += render_seconds;
+                }
+            }
+        }
+
+        const TraceReplayStatistics& getStatistics() const noexcept
+        {
+            return statistics;
+        }
+
+    private:
+        // Returns the ticks the call was scheduled at, or now for VoicevoxTraceReplaySpeed::Maximum.
+        juce::int64 waitUntilScheduled(const VoicevoxTraceRecord& record)
+        {
+            if (schedule.speed == VoicevoxTraceReplaySpeed::Maximum)
+            {
+                return juce::Time::getHighResolutionTicks();
+            }
+
+            const auto target_seconds = (double)(record.startMicroseconds - schedule.firstStartMicroseconds) * 1.0e-6 / schedule.speedScale;
+            const auto scheduled_ticks = schedule.startTicks + juce::Time::secondsToHighResolutionTicks(target_seconds);
+
+            while (!threadShouldExit())
+            {
+                const auto remaining_seconds = target_seconds - juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - schedule.startTicks);
+                if (remaining_seconds <= 0.0)
+                {
+                    break;
+                }
+
+                // NOTE: Sleep is only accurate to a millisecond or so, yield for the last part.
+                if (remaining_seconds > 0.002)
+                {
+                    juce::Thread::sleep((int)((remaining_seconds - 0.001) * 1000.0));
+                }
+                else
+                {
+                    juce::Thread::yield();
+                }
+            }
+
+            return scheduled_ticks;
+        }
+
+        const int workerIndex;
+        TraceReplaySchedule& schedule;
+        const TraceReplayExecuteFunction& execute;
+
+        TraceReplayStatistics statistics;
+    };
+
+    VoicevoxTraceReplayReport runTraceReplay(const std::vector<VoicevoxTraceRecord>& records, const VoicevoxTraceReplayOptions& options, int concurrency, const TraceReplayExecuteFunction& execute)
+    {
+        VoicevoxTraceReplayReport report;
+
+        TraceReplaySchedule schedule;
+        schedule.speed = options.speed;
+
+        jassert(options.speed != VoicevoxTraceReplaySpeed::Scaled || options.speedScale > 0.0);
+        schedule.speedScale = (options.speed == VoicevoxTraceReplaySpeed::Scaled && options.speedScale > 0.0) ? options.speedScale : 1.0;
+
+        for (const auto& record : records)
+        {
+            if (isReplayableTraceRecord(record))
+            {
+                schedule.records.push_back(&record);
+            }
+            else
+            {
+                report.numSkipped++;
+            }
+        }
+
+        // NOTE: Calls of several threads may be recorded slightly out of order.
+        std::stable_sort(schedule.records.begin(), schedule.records.end(),
+                         [](const VoicevoxTraceRecord* lhs, const VoicevoxTraceRecord* rhs) { return lhs->startMicroseconds < rhs->startMicroseconds; });
+
+        if (!schedule.records.empty())
+        {
+            schedule.firstStartMicroseconds = schedule.records.front()->startMicroseconds;
+        }
+
+        std::vector<std::unique_ptr<TraceReplayWorker>> workers;
+        for (int worker_index = 0; worker_index < concurrency; worker_index++)
+        {
+            workers.push_back(std::make_unique<TraceReplayWorker>(worker_index, schedule, execute));
+        }
+
+        schedule.startTicks = juce::Time::getHighResolutionTicks();
+
+        for (auto& worker : workers)
+        {
+            worker->startThread();
+        }
+
+        for (auto& worker : workers)
+        {
+            worker->waitForThreadToExit(-1);
+        }
+
+        report.wallSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - schedule.startTicks);
+
+        std::vector<double> latency_seconds;
+        double audio_render_seconds = 0.0;
+
+        for (const auto& worker : workers)
+        {
+            const auto& statistics = worker->getStatistics();
+
+            latency_seconds.insert(latency_seconds.end(), statistics.latencySeconds.begin(), statistics.latencySeconds.end());
+            report.numFailures += statistics.numFailures;
+            report.numSkipped += statistics.numSkipped;
+            report.numChecksumMatches += statistics.numChecksumMatches;
+            report.numChecksumMismatches += statistics.numChecksumMismatches;
+            report.audioSeconds += statistics.audioSeconds;
+            audio_render_seconds += statistics.audioRenderSeconds;
+        }
+
+        std::sort(latency_seconds.begin(), latency_seconds.end());
+
+        report.numCalls = latency_seconds.size();
+        report.callsPerSecond = report.wallSeconds > 0.0 ? (double)report.numCalls / report.wallSeconds : 0.0;
+        report.latencyP50Milliseconds = getTraceReplayPercentile(latency_seconds, 0.50) * 1000.0;
+        report.latencyP90Milliseconds = getTraceReplayPercentile(latency_seconds, 0.90) * 1000.0;
+        report.latencyP99Milliseconds = getTraceReplayPercentile(latency_seconds, 0.99) * 1000.0;
+        report.latencyMaxMilliseconds = latency_seconds.empty() ? 0.0 : latency_seconds.back() * 1000.0;
+        report.realTimeFactor = report.audioSeconds > 0.0 ? audio_render_seconds / report.audioSeconds : 0.0;
+
+        std::vector<double> recorded_latency_seconds;
+        recorded_latency_seconds.reserve(schedule.records.size());
+        for (const auto* record : schedule.records)
+        {
+            recorded_latency_seconds.push_back((double)record->durationMicroseconds * 1.0e-6);
+        }
+
+        std::sort(recorded_latency_seconds.begin(), recorded_latency_seconds.end());
+
+        report.recordedLatencyP50Milliseconds = getTraceReplayPercentile(recorded_latency_seconds, 0.50) * 1000.0;
+        report.recordedLatencyP99Milliseconds = getTraceReplayPercentile(recorded_latency_seconds, 0.99) * 1000.0;
+
+        return report;
+    }
+}
+
+//==============================================================================
+juce::String VoicevoxTraceReplayReport::toString() const
+{
+    juce::String text;
+
+    text << "calls " << (juce::int64)numCalls << " (failed " << (juce::int64)numFailures << ", skipped " << (juce::int64)numSkipped << "), "
+         << juce::String(callsPerSecond, 2) << " calls/s over " << juce::String(wallSeconds, 2) << " s" << juce::newLine;
+
+    text << "latency ms p50 " << juce::String(latencyP50Milliseconds, 2)
+         << " p90 " << juce::String(latencyP90Milliseconds, 2)
+         << " p99 " << juce::String(latencyP99Milliseconds, 2)
+         << " max " << juce::String(latencyMaxMilliseconds, 2)
+         << " (recorded p50 " << juce::String(recordedLatencyP50Milliseconds, 2)
+         << " p99 " << juce::String(recordedLatencyP99Milliseconds, 2) << ")" << juce::newLine;
+
+    text << "audio " << juce::String(audioSeconds, 2) << " s, real time factor " << juce::String(realTimeFactor, 3) << juce::newLine;
+
+    text << "checksums matched " << (juce::int64)numChecksumMatches << ", mismatched " << (juce::int64)numChecksumMismatches;
+
+    return text;
+}
+
+//==============================================================================
+std::optional<VoicevoxTraceReplayReport> VoicevoxTraceReplayer::replay(const std::vector<VoicevoxTraceRecord>& records, VoicevoxClient& client, const VoicevoxTraceReplayOptions& options)
+{
+    if (!client.isConnected())
+    {
+        return std::nullopt;
+    }
+
+    return runTraceReplay(records, options, std::max(1, options.concurrency),
+                          [&client](int, const VoicevoxTraceRecord& record)
+                          {
+                              VoicevoxThreadPlacement::applyInferenceAffinity();
+                              return executeTraceRecord(client, record);
+                          });
+}
+
+std::optional<VoicevoxTraceReplayReport> VoicevoxTraceReplayer::replayAgainstServer(const std::vector<VoicevoxTraceRecord>& records, int port, const VoicevoxTraceReplayOptions& options)
+{
+    const auto concurrency = std::max(1, options.concurrency);
+
+    // NOTE: VoicevoxRemoteClient serializes calls on its socket, so one connection per worker.
+    std::vector<std::unique_ptr<VoicevoxRemoteClient>> remote_clients;
+    for (int worker_index = 0; worker_index < concurrency; worker_index++)
+    {
+        auto remote_client = std::make_unique<VoicevoxRemoteClient>(port);
+        remote_client->connect();
+
+        if (!remote_client->isConnected())
+        {
+            return std::nullopt;
+        }
+
+        remote_clients.push_back(std::move(remote_client));
+    }
+
+    return runTraceReplay(records, options, concurrency,
+                          [&remote_clients](int worker_index, const VoicevoxTraceRecord& record)
+                          {
+                              VoicevoxThreadPlacement::applyWorkerAffinity();
+                              return executeTraceRecord(*remote_clients[(size_t)worker_index], record);
+                          });
+}
+
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "../voicevox_client/voicevox_client.h"
+#include "voicevox_trace_recorder.h"
+
+namespace voicevox
+{
+
+//==============================================================================
+enum class VoicevoxTraceReplaySpeed
+{
+    // Calls are issued at the recorded timestamps.
+    Original = 0,
+
+    // Recorded timestamps are divided by speedScale.
+    Scaled,
+
+    // Every worker issues its next call as soon as the previous one returns.
+    Maximum
+};
+
+struct VoicevoxTraceReplayOptions
+{
+    VoicevoxTraceReplaySpeed speed{ VoicevoxTraceReplaySpeed::Original };
+    double speedScale{ 1.0 };
+
+    // Number of calls in flight at the same time.
+    int concurrency{ 1 };
+};
+
+struct VoicevoxTraceReplayReport
+{
+    juce::uint64 numCalls{ 0 };
+    juce::uint64 numFailures{ 0 };
+
+    // Records without inputs, or of methods which are not replayed.
+    juce::uint64 numSkipped{ 0 };
+
+    // Compared for calls which succeeded both when recorded and when replayed.
+    juce::uint64 numChecksumMatches{ 0 };
+    juce::uint64 numChecksumMismatches{ 0 };
+
+    double wallSeconds{ 0.0 };
+    double callsPerSecond{ 0.0 };
+
+    // From the scheduled time of each call when paced, from the call start for VoicevoxTraceReplaySpeed::Maximum.
+    double latencyP50Milliseconds{ 0.0 };
+    double latencyP90Milliseconds{ 0.0 };
+    double latencyP99Milliseconds{ 0.0 };
+    double latencyMaxMilliseconds{ 0.0 };
+
+    double recordedLatencyP50Milliseconds{ 0.0 };
+    double recordedLatencyP99Milliseconds{ 0.0 };
+
+    // Render time of audio producing calls divided by the length of the audio, below 1.0 is faster than real time.
+    double audioSeconds{ 0.0 };
+    double realTimeFactor{ 0.0 };
+
+    juce::String toString() const;
+};
+
+//==============================================================================
+/**
+    Re-issues a recorded trace for capacity planning.
+
+    Calls are distributed over the worker threads in recorded order. Outputs
+    are hashed the same way as when recording, so a mismatch shows that the
+    core version, model or device changed the rendered result.
+*/
+class VoicevoxTraceReplayer final
+{
+public:
+    //==============================================================================
+    static std::optional<VoicevoxTraceReplayReport> replay(const std::vector<VoicevoxTraceRecord>& records, VoicevoxClient& client, const VoicevoxTraceReplayOptions& options = {});
+
+    // Load generator for VoicevoxServer, every worker opens its own connection.
+    static std::optional<VoicevoxTraceReplayReport> replayAgainstServer(const std::vector<VoicevoxTraceRecord>& records, int port, const VoicevoxTraceReplayOptions& options = {});
+
+private:
+    //==============================================================================
+    VoicevoxTraceReplayer() = delete;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VoicevoxTraceReplayer)
+};
+
+}